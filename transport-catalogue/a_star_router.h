@@ -0,0 +1,117 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+#include "search_data.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // маршрутизатор A*: поиск Дейкстры, направленный к цели нижней оценкой оставшегося веса.
+    // Оценка heuristic(vertex, to) должна быть согласованной: heuristic(u, to) <= вес(u -> v) + heuristic(v, to),
+    // тогда найденный маршрут кратчайший. Предрасчета не требует.
+    template<typename Weight>
+    class AStarRouter : public RouterBase<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+        using Heuristic = std::function<Weight(VertexId vertex, VertexId to)>;
+
+        AStarRouter(const Graph &graph, Heuristic heuristic);
+
+        std::optional<Weight> BuildRoutePath(VertexId from, VertexId to, std::vector<EdgeId> &edges) const override;
+
+        // несколько целей выгоднее искать одним поиском Дейкстры без направления к цели
+        std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from,
+                                                          const std::vector<VertexId> &to) const override {
+            return to.size() > 1 ? BuildRoutesFromSource(graph_, from, to) : RouterBase<Weight>::BuildRoutes(from, to);
+        }
+
+        bool HasBatchSearch() const override {
+            return true;
+        }
+
+    private:
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr EdgeId NO_EDGE = SearchData<Weight>::NO_EDGE;
+        const Graph &graph_;
+        Heuristic heuristic_;
+    };
+
+    template<typename Weight>
+    AStarRouter<Weight>::AStarRouter(const Graph &graph, Heuristic heuristic)
+            : graph_(graph), heuristic_(std::move(heuristic)) {
+        if (!graph.IsFrozen()) {
+            throw std::logic_error("Graph should be frozen");
+        }
+        for (const auto &edge: graph.GetEdges()) {
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
+
+    template<typename Weight>
+    std::optional<Weight> AStarRouter<Weight>::BuildRoutePath(VertexId from, VertexId to,
+                                                              std::vector<EdgeId> &edges) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        SearchData<Weight> &data = GetThreadSearchData<Weight>();
+        data.Prepare(vertex_count);
+        // оценка считается один раз при первом достижении вершины
+        std::vector<Weight> &estimates = data.estimates;
+        if (estimates.size() < vertex_count) {
+            estimates.resize(vertex_count);
+        }
+        estimates[from] = heuristic_(from, to);
+        data.Reach(from, ZERO_WEIGHT, NO_EDGE, estimates[from]);
+
+        while (!data.heap.empty()) {
+            const auto [priority, vertex] = data.Pop();
+            const Weight weight = data.weights[vertex];
+            if (weight + estimates[vertex] < priority) {
+                continue;  // устаревшая запись очереди
+            }
+            if (vertex == to) {
+                break;
+            }
+            const auto edge_ids = graph_.GetIncidentEdges(vertex);
+            const VertexId *targets = graph_.GetIncidentTargets(vertex).begin();
+            const Weight *edge_weights = graph_.GetIncidentWeights(vertex).begin();
+            for (size_t i = 0, count = edge_ids.end() - edge_ids.begin(); i < count; ++i) {
+                const VertexId target = targets[i];
+                const Weight candidate_weight = weight + edge_weights[i];
+                if (!data.IsReached(target)) {
+                    estimates[target] = heuristic_(target, to);
+                } else if (!(candidate_weight < data.weights[target])) {
+                    continue;
+                }
+                data.Reach(target, candidate_weight, edge_ids.begin()[i], candidate_weight + estimates[target]);
+            }
+        }
+
+        if (!data.IsReached(to)) {
+            return std::nullopt;
+        }
+        edges.clear();
+        for (EdgeId edge_id = data.prev_edges[to]; edge_id != NO_EDGE;
+             edge_id = data.prev_edges[graph_.GetEdge(edge_id).from]) {
+            edges.push_back(edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return data.weights[to];
+    }
+
+}  // namespace graph
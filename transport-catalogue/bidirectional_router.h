@@ -0,0 +1,157 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_data.h"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // маршрутизатор двунаправленной Дейкстры: прямой поиск идет по исходящим ребрам от начала,
+    // обратный - по входящим ребрам от конца; поиск завершается, когда сумма минимальных весов
+    // обеих очередей не меньше лучшего найденного маршрута
+    template<typename Weight>
+    class BidirectionalRouter : public RouterBase<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+        // строит индекс входящих ребер графа
+        explicit BidirectionalRouter(const Graph &graph);
+
+        std::optional<Weight> BuildRoutePath(VertexId from, VertexId to, std::vector<EdgeId> &edges) const override;
+
+    private:
+        // входящее ребро: начало, вес и номер
+        struct ReverseArc {
+            VertexId from;
+            Weight weight;
+            EdgeId edge_id;
+        };
+
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr EdgeId NO_EDGE = SearchData<Weight>::NO_EDGE;
+        const Graph &graph_;
+        // входящие ребра вершины v: [reverse_offsets_[v], reverse_offsets_[v + 1])
+        std::vector<size_t> reverse_offsets_;
+        std::vector<ReverseArc> reverse_arcs_;
+    };
+
+    template<typename Weight>
+    BidirectionalRouter<Weight>::BidirectionalRouter(const Graph &graph)
+            : graph_(graph) {
+        if (!graph.IsFrozen()) {
+            throw std::logic_error("Graph should be frozen");
+        }
+        const size_t vertex_count = graph.GetVertexCount();
+        reverse_offsets_.assign(vertex_count + 1, 0);
+        for (const auto &edge: graph.GetEdges()) {
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            ++reverse_offsets_[edge.to + 1];
+        }
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            reverse_offsets_[vertex + 1] += reverse_offsets_[vertex];
+        }
+        reverse_arcs_.resize(graph.GetEdgeCount());
+        std::vector<size_t> fill(reverse_offsets_.begin(), reverse_offsets_.end() - 1);
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto &edge = graph.GetEdge(edge_id);
+            reverse_arcs_[fill[edge.to]++] = {edge.from, edge.weight, edge_id};
+        }
+    }
+
+    template<typename Weight>
+    std::optional<Weight> BidirectionalRouter<Weight>::BuildRoutePath(VertexId from, VertexId to,
+                                                                      std::vector<EdgeId> &edges) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        SearchData<Weight> &forward = GetThreadSearchData<Weight>(SearchSlot::Forward);
+        SearchData<Weight> &backward = GetThreadSearchData<Weight>(SearchSlot::Backward);
+        forward.Prepare(vertex_count);
+        backward.Prepare(vertex_count);
+        forward.Reach(from, ZERO_WEIGHT, NO_EDGE);
+        backward.Reach(to, ZERO_WEIGHT, NO_EDGE);
+
+        std::optional<Weight> best_weight;
+        VertexId meeting_vertex = from;
+        if (from == to) {
+            best_weight = ZERO_WEIGHT;
+        }
+        // улучшает метку вершины и проверяет маршрут через нее, если вершину уже достиг встречный поиск
+        const auto relax = [&](SearchData<Weight> &data, const SearchData<Weight> &other, VertexId vertex,
+                               Weight weight, EdgeId edge_id) {
+            if (data.IsReached(vertex) && !(weight < data.weights[vertex])) {
+                return;
+            }
+            data.Reach(vertex, weight, edge_id);
+            if (other.IsReached(vertex)) {
+                const Weight route_weight = weight + other.weights[vertex];
+                if (!best_weight || route_weight < *best_weight) {
+                    best_weight = route_weight;
+                    meeting_vertex = vertex;
+                }
+            }
+        };
+
+        while (!forward.heap.empty() && !backward.heap.empty()) {
+            const Weight forward_min = forward.heap.front().first;
+            const Weight backward_min = backward.heap.front().first;
+            if (best_weight && !(forward_min + backward_min < *best_weight)) {
+                break;
+            }
+            if (forward_min <= backward_min) {
+                const auto [weight, vertex] = forward.Pop();
+                if (forward.weights[vertex] < weight) {
+                    continue;
+                }
+                const auto edge_ids = graph_.GetIncidentEdges(vertex);
+                const VertexId *targets = graph_.GetIncidentTargets(vertex).begin();
+                const Weight *edge_weights = graph_.GetIncidentWeights(vertex).begin();
+                for (size_t i = 0, count = edge_ids.end() - edge_ids.begin(); i < count; ++i) {
+                    relax(forward, backward, targets[i], weight + edge_weights[i], edge_ids.begin()[i]);
+                }
+            } else {
+                const auto [weight, vertex] = backward.Pop();
+                if (backward.weights[vertex] < weight) {
+                    continue;
+                }
+                for (size_t i = reverse_offsets_[vertex]; i < reverse_offsets_[vertex + 1]; ++i) {
+                    const ReverseArc &arc = reverse_arcs_[i];
+                    relax(backward, forward, arc.from, weight + arc.weight, arc.edge_id);
+                }
+            }
+        }
+        if (!best_weight) {
+            return std::nullopt;
+        }
+
+        edges.clear();
+        for (EdgeId edge_id = forward.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+             edge_id = forward.prev_edges[graph_.GetEdge(edge_id).from]) {
+            edges.push_back(edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+        for (EdgeId edge_id = backward.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+             edge_id = backward.prev_edges[graph_.GetEdge(edge_id).to]) {
+            edges.push_back(edge_id);
+        }
+
+        Weight weight = ZERO_WEIGHT;
+        for (const EdgeId edge_id: edges) {
+            weight += graph_.GetEdge(edge_id).weight;
+        }
+        return weight;
+    }
+
+}  // namespace graph
@@ -0,0 +1,430 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_data.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Иерархия сжатия (contraction hierarchy): порядок сжатия вершин и ребра-сокращения,
+    // добавленные при сжатии. Ребра иерархии нумеруются так: [0, кол-во ребер графа) - исходные ребра,
+    // дальше сокращения в порядке вектора shortcuts.
+    template<typename Weight>
+    struct ContractionHierarchy {
+        struct Shortcut {
+            VertexId from;
+            VertexId to;
+            Weight weight;
+            EdgeId first;  // ребро иерархии from -> v, где v - сжатая вершина
+            EdgeId second;  // ребро иерархии v -> to
+        };
+
+        std::vector<size_t> ranks;  // ранг вершины - ее номер в порядке сжатия
+        std::vector<Shortcut> shortcuts;
+    };
+
+    // строит иерархию сжатия: вершины сжимаются по возрастанию приоритета (разность добавленных сокращений
+    // и удаленных ребер плюс число уже сжатых соседей), сокращение добавляется, только если
+    // ограниченный поиск свидетеля не нашел обходного пути не длиннее
+    template<typename Weight>
+    class ContractionHierarchyBuilder {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        explicit ContractionHierarchyBuilder(const Graph &graph);
+
+        ContractionHierarchy<Weight> Build();
+
+    private:
+        // дуга оставшегося графа к соседней вершине
+        struct Arc {
+            VertexId vertex;
+            Weight weight;
+            EdgeId edge_id;  // номер ребра иерархии
+        };
+
+        using Shortcut = typename ContractionHierarchy<Weight>::Shortcut;
+
+        // добавляет дугу from -> to, из параллельных дуг остается самая легкая
+        void AddArc(VertexId from, VertexId to, Weight weight, EdgeId edge_id);
+
+        // сокращения, нужные при сжатии vertex
+        void FindShortcuts(VertexId vertex, std::vector<Shortcut> &shortcuts);
+
+        // поиск Дейкстры из from в оставшемся графе без вершины excluded, не дальше max_weight
+        void FindWitnesses(VertexId from, VertexId excluded, Weight max_weight);
+
+        int GetPriority(VertexId vertex);
+
+        void Contract(VertexId vertex);
+
+        static constexpr size_t WITNESS_SETTLE_LIMIT = 500;  // предел осевших вершин поиска свидетеля
+
+        const Graph &graph_;
+        std::vector<std::vector<Arc>> out_arcs_;
+        std::vector<std::vector<Arc>> in_arcs_;
+        std::vector<bool> contracted_;
+        std::vector<int> contracted_neighbors_;
+        ContractionHierarchy<Weight> hierarchy_;
+        SearchData<Weight> witness_search_;
+        std::vector<Shortcut> shortcuts_buffer_;
+    };
+
+    // маршрутизатор по иерархии сжатия: двунаправленный поиск, прямой - только по ребрам к вершинам
+    // большего ранга, обратный - только по ребрам из вершин большего ранга; сокращения пути
+    // раскрываются обратно в исходные ребра графа
+    template<typename Weight>
+    class ContractionHierarchyRouter : public RouterBase<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+        // hierarchy должна жить не меньше маршрутизатора
+        ContractionHierarchyRouter(const Graph &graph, const ContractionHierarchy<Weight> &hierarchy);
+
+        std::optional<Weight> BuildRoutePath(VertexId from, VertexId to, std::vector<EdgeId> &edges) const override;
+
+    private:
+        struct Arc {
+            VertexId vertex;
+            Weight weight;
+            EdgeId edge_id;
+        };
+
+        // концы ребра иерархии
+        std::pair<VertexId, VertexId> GetEnds(EdgeId edge_id) const;
+
+        // дописывает в edges исходные ребра, которые заменяет ребро иерархии
+        void Unpack(EdgeId edge_id, std::vector<EdgeId> &edges) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr EdgeId NO_EDGE = SearchData<Weight>::NO_EDGE;
+        const Graph &graph_;
+        const ContractionHierarchy<Weight> &hierarchy_;
+        // дуги вершины v к вершинам большего ранга: [up_offsets_[v], up_offsets_[v + 1])
+        std::vector<size_t> up_offsets_;
+        std::vector<Arc> up_arcs_;
+        // дуги в вершину v из вершин большего ранга, vertex - начало дуги
+        std::vector<size_t> down_offsets_;
+        std::vector<Arc> down_arcs_;
+    };
+
+    template<typename Weight>
+    ContractionHierarchyBuilder<Weight>::ContractionHierarchyBuilder(const Graph &graph)
+            : graph_(graph), out_arcs_(graph.GetVertexCount()), in_arcs_(graph.GetVertexCount()),
+              contracted_(graph.GetVertexCount(), false), contracted_neighbors_(graph.GetVertexCount(), 0) {
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto &edge = graph.GetEdge(edge_id);
+            if (edge.weight < Weight{}) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            if (edge.from != edge.to) {
+                AddArc(edge.from, edge.to, edge.weight, edge_id);
+            }
+        }
+    }
+
+    template<typename Weight>
+    void ContractionHierarchyBuilder<Weight>::AddArc(VertexId from, VertexId to, Weight weight, EdgeId edge_id) {
+        auto &out_arcs = out_arcs_[from];
+        const auto it = std::find_if(out_arcs.begin(), out_arcs.end(),
+                                     [to](const Arc &arc) { return arc.vertex == to; });
+        if (it == out_arcs.end()) {
+            out_arcs.push_back({to, weight, edge_id});
+            in_arcs_[to].push_back({from, weight, edge_id});
+            return;
+        }
+        if (it->weight <= weight) {
+            return;
+        }
+        *it = {to, weight, edge_id};
+        for (Arc &arc: in_arcs_[to]) {
+            if (arc.vertex == from) {
+                arc = {from, weight, edge_id};
+                break;
+            }
+        }
+    }
+
+    template<typename Weight>
+    void ContractionHierarchyBuilder<Weight>::FindWitnesses(VertexId from, VertexId excluded, Weight max_weight) {
+        SearchData<Weight> &data = witness_search_;
+        data.Prepare(graph_.GetVertexCount());
+        data.Reach(from, Weight{}, SearchData<Weight>::NO_EDGE);
+        size_t settled = 0;
+        while (!data.heap.empty() && settled < WITNESS_SETTLE_LIMIT) {
+            const auto [weight, vertex] = data.Pop();
+            if (data.weights[vertex] < weight) {
+                continue;
+            }
+            if (max_weight < weight) {
+                break;
+            }
+            ++settled;
+            for (const Arc &arc: out_arcs_[vertex]) {
+                if (contracted_[arc.vertex] || arc.vertex == excluded) {
+                    continue;
+                }
+                const Weight candidate_weight = weight + arc.weight;
+                if (!data.IsReached(arc.vertex) || candidate_weight < data.weights[arc.vertex]) {
+                    data.Reach(arc.vertex, candidate_weight, arc.edge_id);
+                }
+            }
+        }
+    }
+
+    template<typename Weight>
+    void ContractionHierarchyBuilder<Weight>::FindShortcuts(VertexId vertex, std::vector<Shortcut> &shortcuts) {
+        shortcuts.clear();
+        for (const Arc &in_arc: in_arcs_[vertex]) {
+            if (contracted_[in_arc.vertex]) {
+                continue;
+            }
+            std::optional<Weight> max_weight;
+            for (const Arc &out_arc: out_arcs_[vertex]) {
+                if (!contracted_[out_arc.vertex] && out_arc.vertex != in_arc.vertex) {
+                    const Weight weight = in_arc.weight + out_arc.weight;
+                    if (!max_weight || *max_weight < weight) {
+                        max_weight = weight;
+                    }
+                }
+            }
+            if (!max_weight) {
+                continue;
+            }
+            FindWitnesses(in_arc.vertex, vertex, *max_weight);
+            for (const Arc &out_arc: out_arcs_[vertex]) {
+                if (contracted_[out_arc.vertex] || out_arc.vertex == in_arc.vertex) {
+                    continue;
+                }
+                const Weight weight = in_arc.weight + out_arc.weight;
+                if (!witness_search_.IsReached(out_arc.vertex) || weight < witness_search_.weights[out_arc.vertex]) {
+                    shortcuts.push_back({in_arc.vertex, out_arc.vertex, weight, in_arc.edge_id, out_arc.edge_id});
+                }
+            }
+        }
+    }
+
+    template<typename Weight>
+    int ContractionHierarchyBuilder<Weight>::GetPriority(VertexId vertex) {
+        FindShortcuts(vertex, shortcuts_buffer_);
+        int removed_arcs = 0;
+        for (const Arc &arc: in_arcs_[vertex]) {
+            removed_arcs += contracted_[arc.vertex] ? 0 : 1;
+        }
+        for (const Arc &arc: out_arcs_[vertex]) {
+            removed_arcs += contracted_[arc.vertex] ? 0 : 1;
+        }
+        return static_cast<int>(shortcuts_buffer_.size()) - removed_arcs + contracted_neighbors_[vertex];
+    }
+
+    template<typename Weight>
+    void ContractionHierarchyBuilder<Weight>::Contract(VertexId vertex) {
+        FindShortcuts(vertex, shortcuts_buffer_);
+        const EdgeId first_shortcut_id = graph_.GetEdgeCount() + hierarchy_.shortcuts.size();
+        for (size_t i = 0; i < shortcuts_buffer_.size(); ++i) {
+            const Shortcut &shortcut = shortcuts_buffer_[i];
+            AddArc(shortcut.from, shortcut.to, shortcut.weight, first_shortcut_id + i);
+            hierarchy_.shortcuts.push_back(shortcut);
+        }
+        contracted_[vertex] = true;
+        for (const Arc &arc: in_arcs_[vertex]) {
+            ++contracted_neighbors_[arc.vertex];
+        }
+        for (const Arc &arc: out_arcs_[vertex]) {
+            ++contracted_neighbors_[arc.vertex];
+        }
+    }
+
+    template<typename Weight>
+    ContractionHierarchy<Weight> ContractionHierarchyBuilder<Weight>::Build() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        hierarchy_.ranks.assign(vertex_count, 0);
+        // очередь с ленивым обновлением: приоритет пересчитывается при извлечении
+        using QueueItem = std::pair<int, VertexId>;
+        std::vector<QueueItem> queue;
+        queue.reserve(vertex_count);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            queue.emplace_back(GetPriority(vertex), vertex);
+        }
+        std::make_heap(queue.begin(), queue.end(), std::greater<>{});
+
+        size_t rank = 0;
+        while (!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<>{});
+            const VertexId vertex = queue.back().second;
+            queue.pop_back();
+            const int priority = GetPriority(vertex);
+            if (!queue.empty() && queue.front().first < priority) {
+                queue.emplace_back(priority, vertex);
+                std::push_heap(queue.begin(), queue.end(), std::greater<>{});
+                continue;
+            }
+            Contract(vertex);
+            hierarchy_.ranks[vertex] = rank++;
+        }
+        return std::move(hierarchy_);
+    }
+
+    template<typename Weight>
+    ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph &graph,
+                                                                   const ContractionHierarchy<Weight> &hierarchy)
+            : graph_(graph), hierarchy_(hierarchy) {
+        const size_t vertex_count = graph.GetVertexCount();
+        if (hierarchy.ranks.size() != vertex_count) {
+            throw std::invalid_argument("Contraction hierarchy doesn't match the graph");
+        }
+        const size_t hierarchy_edge_count = graph.GetEdgeCount() + hierarchy.shortcuts.size();
+        // дуги раскладываются по вершинам в два прохода: подсчет и заполнение
+        up_offsets_.assign(vertex_count + 1, 0);
+        down_offsets_.assign(vertex_count + 1, 0);
+        for (EdgeId edge_id = 0; edge_id < hierarchy_edge_count; ++edge_id) {
+            const auto [from, to] = GetEnds(edge_id);
+            if (hierarchy.ranks[from] < hierarchy.ranks[to]) {
+                ++up_offsets_[from + 1];
+            } else if (hierarchy.ranks[to] < hierarchy.ranks[from]) {
+                ++down_offsets_[to + 1];
+            }
+        }
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            up_offsets_[vertex + 1] += up_offsets_[vertex];
+            down_offsets_[vertex + 1] += down_offsets_[vertex];
+        }
+        up_arcs_.resize(up_offsets_.back());
+        down_arcs_.resize(down_offsets_.back());
+        std::vector<size_t> up_fill(up_offsets_.begin(), up_offsets_.end() - 1);
+        std::vector<size_t> down_fill(down_offsets_.begin(), down_offsets_.end() - 1);
+        for (EdgeId edge_id = 0; edge_id < hierarchy_edge_count; ++edge_id) {
+            const auto [from, to] = GetEnds(edge_id);
+            const Weight weight = edge_id < graph.GetEdgeCount()
+                                  ? graph.GetEdge(edge_id).weight
+                                  : hierarchy.shortcuts[edge_id - graph.GetEdgeCount()].weight;
+            if (hierarchy.ranks[from] < hierarchy.ranks[to]) {
+                up_arcs_[up_fill[from]++] = {to, weight, edge_id};
+            } else if (hierarchy.ranks[to] < hierarchy.ranks[from]) {
+                down_arcs_[down_fill[to]++] = {from, weight, edge_id};
+            }
+        }
+    }
+
+    template<typename Weight>
+    std::pair<VertexId, VertexId> ContractionHierarchyRouter<Weight>::GetEnds(EdgeId edge_id) const {
+        if (edge_id < graph_.GetEdgeCount()) {
+            const auto &edge = graph_.GetEdge(edge_id);
+            return {edge.from, edge.to};
+        }
+        const auto &shortcut = hierarchy_.shortcuts[edge_id - graph_.GetEdgeCount()];
+        return {shortcut.from, shortcut.to};
+    }
+
+    template<typename Weight>
+    void ContractionHierarchyRouter<Weight>::Unpack(EdgeId edge_id, std::vector<EdgeId> &edges) const {
+        // обход в глубину без рекурсии: сначала first, затем second; стек потока переиспользуется
+        static thread_local std::vector<EdgeId> stack;
+        stack.assign(1, edge_id);
+        while (!stack.empty()) {
+            const EdgeId current = stack.back();
+            stack.pop_back();
+            if (current < graph_.GetEdgeCount()) {
+                edges.push_back(current);
+                continue;
+            }
+            const auto &shortcut = hierarchy_.shortcuts[current - graph_.GetEdgeCount()];
+            stack.push_back(shortcut.second);
+            stack.push_back(shortcut.first);
+        }
+    }
+
+    template<typename Weight>
+    std::optional<Weight> ContractionHierarchyRouter<Weight>::BuildRoutePath(VertexId from, VertexId to,
+                                                                             std::vector<EdgeId> &edges) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        SearchData<Weight> &forward = GetThreadSearchData<Weight>(SearchSlot::Forward);
+        SearchData<Weight> &backward = GetThreadSearchData<Weight>(SearchSlot::Backward);
+        forward.Prepare(vertex_count);
+        backward.Prepare(vertex_count);
+        forward.Reach(from, ZERO_WEIGHT, NO_EDGE);
+        backward.Reach(to, ZERO_WEIGHT, NO_EDGE);
+
+        std::optional<Weight> best_weight;
+        VertexId meeting_vertex = from;
+        // шаг поиска: оседает вершина с минимальным весом, дуги arcs релаксируются
+        const auto step = [&](SearchData<Weight> &data, const SearchData<Weight> &other,
+                              const std::vector<size_t> &offsets, const std::vector<Arc> &arcs) {
+            const auto [weight, vertex] = data.Pop();
+            if (data.weights[vertex] < weight) {
+                return;
+            }
+            if (other.IsReached(vertex)) {
+                const Weight route_weight = weight + other.weights[vertex];
+                if (!best_weight || route_weight < *best_weight) {
+                    best_weight = route_weight;
+                    meeting_vertex = vertex;
+                }
+            }
+            for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+                const Arc &arc = arcs[i];
+                const Weight candidate_weight = weight + arc.weight;
+                if (!data.IsReached(arc.vertex) || candidate_weight < data.weights[arc.vertex]) {
+                    data.Reach(arc.vertex, candidate_weight, arc.edge_id);
+                }
+            }
+        };
+        // направление прекращается, когда его минимальный вес не меньше лучшего найденного маршрута
+        const auto is_active = [&best_weight](const SearchData<Weight> &data) {
+            return !data.heap.empty() && (!best_weight || data.heap.front().first < *best_weight);
+        };
+        while (true) {
+            const bool forward_active = is_active(forward);
+            const bool backward_active = is_active(backward);
+            if (!forward_active && !backward_active) {
+                break;
+            }
+            if (forward_active && (!backward_active || forward.heap.front().first <= backward.heap.front().first)) {
+                step(forward, backward, up_offsets_, up_arcs_);
+            } else {
+                step(backward, forward, down_offsets_, down_arcs_);
+            }
+        }
+        if (!best_weight) {
+            return std::nullopt;
+        }
+
+        // ребра иерархии от from до точки встречи и от точки встречи до to
+        static thread_local std::vector<EdgeId> hierarchy_edges;
+        hierarchy_edges.clear();
+        for (EdgeId edge_id = forward.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+             edge_id = forward.prev_edges[GetEnds(edge_id).first]) {
+            hierarchy_edges.push_back(edge_id);
+        }
+        std::reverse(hierarchy_edges.begin(), hierarchy_edges.end());
+        for (EdgeId edge_id = backward.prev_edges[meeting_vertex]; edge_id != NO_EDGE;
+             edge_id = backward.prev_edges[GetEnds(edge_id).second]) {
+            hierarchy_edges.push_back(edge_id);
+        }
+
+        Weight weight = ZERO_WEIGHT;
+        edges.clear();
+        for (const EdgeId edge_id: hierarchy_edges) {
+            Unpack(edge_id, edges);
+        }
+        for (const EdgeId edge_id: edges) {
+            weight += graph_.GetEdge(edge_id).weight;
+        }
+        return weight;
+    }
+
+}  // namespace graph
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_data.h"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // маршруты из from в каждую из вершин to одним поиском Дейкстры, который завершается,
+    // когда из очереди извлечены все вершины to
+    template<typename Weight>
+    std::vector<std::optional<typename RouterBase<Weight>::RouteInfo>>
+    BuildRoutesFromSource(const DirectedWeightedGraph<Weight> &graph, VertexId from, const std::vector<VertexId> &to) {
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+        constexpr Weight zero_weight{};
+        constexpr EdgeId no_edge = SearchData<Weight>::NO_EDGE;
+        const size_t vertex_count = graph.GetVertexCount();
+        if (from >= vertex_count || std::any_of(to.begin(), to.end(), [vertex_count](VertexId vertex) {
+            return vertex >= vertex_count;
+        })) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        std::vector<VertexId> targets = to;
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+        size_t remaining = targets.size();
+
+        SearchData<Weight> &data = GetThreadSearchData<Weight>();
+        data.Prepare(vertex_count);
+        data.Reach(from, zero_weight, no_edge);
+        while (remaining > 0 && !data.heap.empty()) {
+            const auto [weight, vertex] = data.Pop();
+            if (data.weights[vertex] < weight) {
+                continue;  // устаревшая запись очереди
+            }
+            if (std::binary_search(targets.begin(), targets.end(), vertex)) {
+                --remaining;
+            }
+            const auto edge_ids = graph.GetIncidentEdges(vertex);
+            const VertexId *edge_targets = graph.GetIncidentTargets(vertex).begin();
+            const Weight *edge_weights = graph.GetIncidentWeights(vertex).begin();
+            for (size_t i = 0, count = edge_ids.end() - edge_ids.begin(); i < count; ++i) {
+                const Weight candidate_weight = weight + edge_weights[i];
+                if (!data.IsReached(edge_targets[i]) || candidate_weight < data.weights[edge_targets[i]]) {
+                    data.Reach(edge_targets[i], candidate_weight, edge_ids.begin()[i]);
+                }
+            }
+        }
+
+        std::vector<std::optional<RouteInfo>> routes;
+        routes.reserve(to.size());
+        for (const VertexId vertex: to) {
+            if (!data.IsReached(vertex)) {
+                routes.emplace_back(std::nullopt);
+                continue;
+            }
+            std::vector<EdgeId> edges;
+            for (EdgeId edge_id = data.prev_edges[vertex]; edge_id != no_edge;
+                 edge_id = data.prev_edges[graph.GetEdge(edge_id).from]) {
+                edges.push_back(edge_id);
+            }
+            std::reverse(edges.begin(), edges.end());
+            routes.emplace_back(RouteInfo{data.weights[vertex], std::move(edges)});
+        }
+        return routes;
+    }
+
+    // поиск Дейкстры из from, ограниченный весом max_weight: вызывает visit(vertex, weight) для каждой
+    // вершины с весом кратчайшего пути не больше max_weight в порядке возрастания веса
+    template<typename Weight, typename Visitor>
+    void ForEachReachable(const DirectedWeightedGraph<Weight> &graph, VertexId from, Weight max_weight, Visitor visit) {
+        constexpr Weight zero_weight{};
+        const size_t vertex_count = graph.GetVertexCount();
+        if (from >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        if (max_weight < zero_weight) {
+            return;
+        }
+        SearchData<Weight> &data = GetThreadSearchData<Weight>();
+        data.Prepare(vertex_count);
+        data.Reach(from, zero_weight, SearchData<Weight>::NO_EDGE);
+        while (!data.heap.empty()) {
+            const auto [weight, vertex] = data.Pop();
+            if (data.weights[vertex] < weight) {
+                continue;  // устаревшая запись очереди
+            }
+            if (max_weight < weight) {
+                break;  // все остальные вершины дальше
+            }
+            visit(vertex, weight);
+            const auto edge_ids = graph.GetIncidentEdges(vertex);
+            const VertexId *edge_targets = graph.GetIncidentTargets(vertex).begin();
+            const Weight *edge_weights = graph.GetIncidentWeights(vertex).begin();
+            for (size_t i = 0, count = edge_ids.end() - edge_ids.begin(); i < count; ++i) {
+                const Weight candidate_weight = weight + edge_weights[i];
+                // вершины за пределами бюджета в очередь не попадают
+                if (max_weight < candidate_weight) {
+                    continue;
+                }
+                if (!data.IsReached(edge_targets[i]) || candidate_weight < data.weights[edge_targets[i]]) {
+                    data.Reach(edge_targets[i], candidate_weight, edge_ids.begin()[i]);
+                }
+            }
+        }
+    }
+
+    // маршрутизатор без предрасчета: на каждый запрос выполняет поиск Дейкстры из начальной вершины
+    template<typename Weight>
+    class DijkstraRouter : public RouterBase<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+        explicit DijkstraRouter(const Graph &graph);
+
+        std::optional<Weight> BuildRoutePath(VertexId from, VertexId to, std::vector<EdgeId> &edges) const override;
+
+        std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from,
+                                                          const std::vector<VertexId> &to) const override {
+            return BuildRoutesFromSource(graph_, from, to);
+        }
+
+        bool HasBatchSearch() const override {
+            return true;
+        }
+
+    private:
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr EdgeId NO_EDGE = SearchData<Weight>::NO_EDGE;
+        const Graph &graph_;
+    };
+
+    template<typename Weight>
+    DijkstraRouter<Weight>::DijkstraRouter(const Graph &graph)
+            : graph_(graph) {
+        if (!graph.IsFrozen()) {
+            throw std::logic_error("Graph should be frozen");
+        }
+        for (const auto &edge: graph.GetEdges()) {
+            if (edge.weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
+
+    template<typename Weight>
+    std::optional<Weight> DijkstraRouter<Weight>::BuildRoutePath(VertexId from, VertexId to,
+                                                                 std::vector<EdgeId> &edges) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        SearchData<Weight> &data = GetThreadSearchData<Weight>();
+        data.Prepare(vertex_count);
+        data.Reach(from, ZERO_WEIGHT, NO_EDGE);
+
+        while (!data.heap.empty()) {
+            const auto [weight, vertex] = data.Pop();
+            if (data.weights[vertex] < weight) {
+                continue;  // устаревшая запись очереди
+            }
+            if (vertex == to) {
+                break;
+            }
+            // исходящие ребра читаются подряд из CSR-массивов графа
+            const auto edge_ids = graph_.GetIncidentEdges(vertex);
+            const VertexId *targets = graph_.GetIncidentTargets(vertex).begin();
+            const Weight *edge_weights = graph_.GetIncidentWeights(vertex).begin();
+            for (size_t i = 0, count = edge_ids.end() - edge_ids.begin(); i < count; ++i) {
+                const Weight candidate_weight = weight + edge_weights[i];
+                if (!data.IsReached(targets[i]) || candidate_weight < data.weights[targets[i]]) {
+                    data.Reach(targets[i], candidate_weight, edge_ids.begin()[i]);
+                }
+            }
+        }
+
+        if (!data.IsReached(to)) {
+            return std::nullopt;
+        }
+        edges.clear();
+        for (EdgeId edge_id = data.prev_edges[to]; edge_id != NO_EDGE;
+             edge_id = data.prev_edges[graph_.GetEdge(edge_id).from]) {
+            edges.push_back(edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return data.weights[to];
+    }
+
+}  // namespace graph
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "geo.h"
+#include <memory>
+#include <optional>
 #include <set>
 #include <string>
 #include <variant>
@@ -17,15 +19,44 @@ namespace domain {
         const std::string routing_settings = "routing_settings"s;
         // process_requests
         const std::string stat = "stat_requests"s;
+        const std::string update = "update_requests"s; // изменения базы перед stat_requests
         // common
         const std::string srlzt_settings = "serialization_settings"s;
 
         // параметры serialization_settings
         const std::string file = "file"s;
+        const std::string router_table_file = "router_table_file"s;
 
         // параметры routing_settings
         const std::string bus_velocity = "bus_velocity"s;
         const std::string bus_wait_time = "bus_wait_time"s;
+        const std::string router = "router"s;
+        const std::string store_router_table = "store_router_table"s;
+        const std::string graph_model = "graph_model"s;
+        const std::string route_cache_size = "route_cache_size"s;
+        const std::string stop_order = "stop_order"s;
+        const std::string all_pairs_table = "all_pairs_table"s;
+
+        // значения параметра router
+        const std::string router_all_pairs = "all_pairs"s;
+        const std::string router_dijkstra = "dijkstra"s;
+        const std::string router_contraction_hierarchy = "contraction_hierarchy"s;
+        const std::string router_a_star = "a_star"s;
+        const std::string router_bidirectional = "bidirectional"s;
+
+        // значения параметра graph_model
+        const std::string graph_model_complete = "complete"s;
+        const std::string graph_model_linear = "linear"s;
+
+        // значения параметра stop_order
+        const std::string stop_order_input = "input"s;
+        const std::string stop_order_hilbert = "hilbert"s;
+        const std::string stop_order_bfs = "bfs"s;
+
+        // значения параметра all_pairs_table
+        const std::string all_pairs_table_prev_edges = "prev_edges"s;
+        const std::string all_pairs_table_next_hop = "next_hop"s;
+        const std::string all_pairs_table_next_hop_runs = "next_hop_runs"s;
 
         // параметры общие для base_requests
         const std::string name = "name"s;
@@ -39,6 +70,18 @@ namespace domain {
         // параметры base_requests type Bus
         const std::string is_roundtrip = "is_roundtrip"s;
         const std::string stops = "stops"s;
+        // расписание автобуса: список отправлений с первой остановки, минуты от начала суток,
+        // или интервал движения с первым и последним отправлением
+        const std::string departures = "departures"s;
+        const std::string headway = "headway"s;
+        const std::string first_departure = "first_departure"s;
+        const std::string last_departure = "last_departure"s;
+
+        // параметры update_requests: type Distance (from, to, distance), type Bus (как в base_requests),
+        // type RemoveBus (name)
+        const std::string distance = "Distance"s;
+        const std::string distance_value = "distance"s;
+        const std::string remove_bus = "RemoveBus"s;
 
         // параметры stat_requests
         const std::string id = "id"s;
@@ -46,6 +89,12 @@ namespace domain {
         const std::string from = "from"s;
         const std::string to = "to"s;
         const std::string map = "Map"s;
+        const std::string time_matrix = "TimeMatrix"s;
+        const std::string reachable = "Reachable"s;
+        const std::string routes = "Routes"s;
+        const std::string count = "count"s;
+        const std::string max_time = "max_time"s;
+        const std::string departure_time = "departure_time"s;
 
         // параметры общие для stat_requests и base_requests
         const std::string bus = "Bus"s;
@@ -57,11 +106,19 @@ namespace domain {
         std::string data;
     };
 
+    // наибольшее число маршрутов запроса Routes: число простых путей растет экспоненциально с размером сети
+    inline constexpr int MAX_ROUTES_COUNT = 16;
+
     struct RequestOut {
         int id;
         std::string type;
         std::string name;
         std::optional<std::string> name_to;
+        std::vector<std::string> names_from; // TimeMatrix
+        std::vector<std::string> names_to; // TimeMatrix
+        double max_time = 0; // Reachable, минуты
+        size_t count = 3; // Routes, наибольшее число маршрутов, не больше MAX_ROUTES_COUNT
+        std::optional<double> departure_time; // Route по расписанию, минуты от начала суток
     };
 
     struct BusStat {
@@ -94,6 +151,7 @@ namespace domain {
         std::string name;
         std::vector<const Stop *> stops;
         bool is_round;
+        std::vector<double> departures; // отправления рейсов с первой остановки, минуты от начала суток
     };
 
     struct CmpBuses {
@@ -108,30 +166,81 @@ namespace domain {
         size_t lenght;
     };
 
+    // способ поиска маршрутов
+    enum class RouterType {
+        AllPairs, // предрасчет всех пар остановок
+        Dijkstra, // поиск на каждый запрос, без предрасчета
+        ContractionHierarchy, // иерархия сжатия строится в make_base и хранится в базе
+        AStar, // A* с оценкой по расстоянию между координатами остановок, без предрасчета
+        Bidirectional, // двунаправленный поиск, без предрасчета
+    };
+
+    // способ построения графа маршрутизации
+    enum class GraphModel {
+        Complete, // ребро от каждой остановки автобуса до каждой следующей, O(n^2) ребер на автобус
+        Linear, // вершины остановок и вершины "в автобусе", O(n) ребер на автобус
+    };
+
+    // порядок нумерации вершин остановок в графе и таблицах маршрутизаторов
+    enum class StopOrder {
+        Input, // в порядке остановок справочника
+        Hilbert, // по кривой Гильберта по координатам: близкие остановки получают близкие номера
+        Bfs, // в порядке обхода в ширину по соседним остановкам маршрутов автобусов
+    };
+
+    // вид таблицы маршрутизатора всех пар
+    enum class AllPairsTable {
+        PrevEdges, // вес и последнее ребро маршрута каждой пары; таблица обновляется при изменениях справочника
+        NextHop, // только первый шаг маршрута в наименьшей целой ширине, веса считаются по ребрам
+        NextHopRuns, // то же со сжатием серий одинаковых шагов в строках
+    };
+
     struct RoutingSettings {
         int bus_wait_time_minut = 0; // минуты
         double bus_velocity = 0; // км/ч
+        RouterType router_type = RouterType::AllPairs;
+        bool store_router_table = false; // сохранять в базу рассчитанную таблицу маршрутов всех пар
+        GraphModel graph_model = GraphModel::Complete;
+        size_t route_cache_size = 0; // число маршрутов в кэше результатов, 0 - кэш отключен
+        StopOrder stop_order = StopOrder::Input;
+        AllPairsTable all_pairs_table = AllPairsTable::PrevEdges;
     };
 
     struct RoutStat {
 
-        struct ItemsWait {
-            std::string type;
-            double time = 0;
-            std::string stop_name;
+        enum class ItemType {
+            Wait, // ожидание автобуса на остановке
+            Bus, // поездка на автобусе
         };
 
-        struct ItemsBus {
-            std::string type;
-            double time = 0;
-            size_t span_count = 0;
-            std::string bus;
+        // элемент маршрута; имена не копируются, а задаются номером в таблицах имен маршрутизатора:
+        // для Wait - номер остановки, для Bus - номер автобуса
+        struct Item {
+            ItemType type = ItemType::Wait;
+            double time = 0; // минуты
+            size_t span_count = 0; // кол-во пролетов, только для Bus
+            size_t name_id = 0;
+
+            bool operator==(const Item &other) const {
+                return type == other.type && time == other.time && span_count == other.span_count
+                       && name_id == other.name_id;
+            }
         };
 
-        using VariantItem = std::variant<ItemsBus, ItemsWait>;
-
         double total_time = 0; // минуты
-        std::vector<VariantItem> items;
+        std::vector<Item> items;
+    };
+
+    // готовый маршрут; nullptr - маршрут не найден
+    using RoutStatPtr = std::shared_ptr<const RoutStat>;
+
+    // время в пути от остановки строки до остановки столбца, nullopt - маршрута нет
+    using TimeMatrix = std::vector<std::vector<std::optional<double>>>;
+
+    // остановка, достижимая за отведенное время
+    struct ReachableStop {
+        std::string_view stop_name;
+        double time = 0; // минуты
     };
 
     double ComputeDistance(const Stop *from_stop, const Stop *to_stop);
@@ -2,6 +2,7 @@
 
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo {
@@ -17,4 +18,33 @@ namespace geo {
                * 6371000;
     }
 
+    uint32_t ComputeHilbertIndex(Coordinates point, Coordinates min, Coordinates max) {
+        constexpr uint32_t side = 1u << 16;
+        // координата в номер клетки сетки, вырожденный прямоугольник - одна клетка
+        const auto to_cell = [](double value, double low, double high) {
+            if (!(high > low)) {
+                return uint32_t{0};
+            }
+            const double cell = std::floor((value - low) / (high - low) * side);
+            return static_cast<uint32_t>(std::clamp(cell, 0.0, static_cast<double>(side - 1)));
+        };
+        uint32_t x = to_cell(point.lng, min.lng, max.lng);
+        uint32_t y = to_cell(point.lat, min.lat, max.lat);
+        uint32_t index = 0;
+        for (uint32_t half = side / 2; half > 0; half /= 2) {
+            const uint32_t rx = (x & half) > 0;
+            const uint32_t ry = (y & half) > 0;
+            index += half * half * ((3 * rx) ^ ry);
+            // поворот четверти, чтобы кривая внутри нее шла в нужном направлении
+            if (ry == 0) {
+                if (rx == 1) {
+                    x = side - 1 - x;
+                    y = side - 1 - y;
+                }
+                std::swap(x, y);
+            }
+        }
+        return index;
+    }
+
 }  // namespace geo
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace geo {
 
     struct Coordinates {
@@ -16,4 +18,8 @@ namespace geo {
 
     double ComputeDistance(Coordinates from, Coordinates to);
 
+    // номер клетки с точкой point на кривой Гильберта, заполняющей прямоугольник [min, max] сеткой 2^16 x 2^16;
+    // близкие номера - у близких точек
+    uint32_t ComputeHilbertIndex(Coordinates point, Coordinates min, Coordinates max);
+
 }  // namespace geo
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "ranges.h"
 
 #include <cstdlib>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
@@ -17,52 +18,164 @@ namespace graph {
         Weight weight;  // Вес ребра
     };
 
+    // Граф строится добавлением ребер, после чего может быть "заморожен" (Freeze) в CSR-представление:
+    // массив смещений по вершинам и непрерывные массивы номеров, концов и весов исходящих ребер.
+    // Обход замороженного графа читает память последовательно вместо списков в отдельных блоках кучи.
     template<typename Weight>
     class DirectedWeightedGraph {
     private:
         using IncidenceList = std::vector<EdgeId>;  // Список инцидентных ребер для каждой вершины
-        using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;  // Диапазон инцидентных ребер для вершины
+        using IncidentEdgesRange = ranges::Range<const EdgeId *>;  // Диапазон инцидентных ребер для вершины
+        using IncidentTargetsRange = ranges::Range<const VertexId *>;  // Диапазон концов инцидентных ребер
+        using IncidentWeightsRange = ranges::Range<const Weight *>;  // Диапазон весов инцидентных ребер
 
     public:
         DirectedWeightedGraph() = default;  // Конструктор по умолчанию
 
         explicit DirectedWeightedGraph(size_t vertex_count);  // Конструктор с указанием количества вершин
 
-        EdgeId AddEdge(const Edge<Weight> &edge);  // Добавление ребра в граф
+        // Замороженный граф из готового списка ребер, номера ребер - позиции в списке
+        DirectedWeightedGraph(size_t vertex_count, std::vector<Edge<Weight>> &&edges);
+
+        EdgeId AddEdge(const Edge<Weight> &edge);  // Добавление ребра в граф, замороженный граф размораживается
+
+        void Freeze();  // Перевод графа в CSR-представление
+
+        void SetEdgeWeight(EdgeId edge_id, Weight weight);  // Изменение веса ребра без перестройки графа
+
+        bool IsFrozen() const;  // Граф в CSR-представлении
 
         size_t GetVertexCount() const;  // Получение количества вершин в графе
 
         size_t GetEdgeCount() const;  // Получение количества ребер в графе
 
-        const Edge<Weight> &GetEdge(EdgeId edge_id) const;  // Получение ребра по его идентификатору
+        const Edge<Weight> &GetEdge(EdgeId edge_id) const;  // Получение ребра по его идентификатору, без проверки границ
 
         IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;  // Получение диапазона инцидентных ребер для вершины
 
-        const std::vector <Edge<Weight>> &GetEdges() const;  // Получение всех ребер графа
+        // Концы и веса инцидентных ребер в том же порядке, что и GetIncidentEdges; только для замороженного графа
+        IncidentTargetsRange GetIncidentTargets(VertexId vertex) const;
+
+        IncidentWeightsRange GetIncidentWeights(VertexId vertex) const;
 
-        const std::vector <IncidenceList> &GetIncidenceLists() const;  // Получение списков инцидентных ребер для каждой вершины
+        const std::vector <Edge<Weight>> &GetEdges() const;  // Получение всех ребер графа
 
     private:
+        size_t vertex_count_ = 0;  // Количество вершин
         std::vector <Edge<Weight>> edges_;  // Вектор ребер графа
-        std::vector <IncidenceList> incidence_lists_;  // Вектор списков инцидентных ребер для каждой вершины
+        std::vector <IncidenceList> incidence_lists_;  // Вектор списков инцидентных ребер, пока граф не заморожен
+
+        // CSR-представление: ребра вершины v занимают позиции [csr_offsets_[v], csr_offsets_[v + 1])
+        std::vector<size_t> csr_offsets_;
+        std::vector<EdgeId> csr_edge_ids_;
+        std::vector<VertexId> csr_targets_;
+        std::vector<Weight> csr_weights_;
     };
 
     template<typename Weight>
     DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-            : incidence_lists_(vertex_count) {
+            : vertex_count_(vertex_count), incidence_lists_(vertex_count) {
+    }
+
+    template<typename Weight>
+    DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count, std::vector<Edge<Weight>> &&edges)
+            : vertex_count_(vertex_count), edges_(std::move(edges)) {
+        // CSR-массивы сразу сортировкой подсчетом по началу ребра; внутри вершины ребра идут по возрастанию номера,
+        // как после AddEdge и Freeze
+        csr_offsets_.assign(vertex_count_ + 1, 0);
+        for (const auto &edge: edges_) {
+            if (edge.from >= vertex_count_ || edge.to >= vertex_count_) {
+                throw std::out_of_range("Edge's vertex is out of range");
+            }
+            ++csr_offsets_[edge.from + 1];
+        }
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            csr_offsets_[vertex + 1] += csr_offsets_[vertex];
+        }
+        csr_edge_ids_.resize(edges_.size());
+        csr_targets_.resize(edges_.size());
+        csr_weights_.resize(edges_.size());
+        std::vector<size_t> fill(csr_offsets_.begin(), csr_offsets_.end() - 1);
+        for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+            const size_t position = fill[edges_[edge_id].from]++;
+            csr_edge_ids_[position] = edge_id;
+            csr_targets_[position] = edges_[edge_id].to;
+            csr_weights_[position] = edges_[edge_id].weight;
+        }
     }
 
     template<typename Weight>
     EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight> &edge) {
+        if (edge.from >= vertex_count_ || edge.to >= vertex_count_) {
+            throw std::out_of_range("Edge's vertex is out of range");
+        }
+        if (IsFrozen()) {
+            // восстановление списков инцидентности из CSR-представления
+            incidence_lists_.assign(vertex_count_, {});
+            for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+                incidence_lists_[vertex].assign(csr_edge_ids_.begin() + csr_offsets_[vertex],
+                                                csr_edge_ids_.begin() + csr_offsets_[vertex + 1]);
+            }
+            csr_offsets_.clear();
+            csr_edge_ids_.clear();
+            csr_targets_.clear();
+            csr_weights_.clear();
+        }
         edges_.push_back(edge);  // Добавление ребра в вектор ребер
         const EdgeId id = edges_.size() - 1;  // Получение идентификатора добавленного ребра
-        incidence_lists_.at(edge.from).push_back(id);  // Добавление идентификатора ребра в список инцидентных ребер для начальной вершины
+        incidence_lists_[edge.from].push_back(id);  // Добавление идентификатора ребра в список инцидентных ребер для начальной вершины
         return id;  // Возвращение идентификатора ребра
     }
 
+    template<typename Weight>
+    void DirectedWeightedGraph<Weight>::Freeze() {
+        if (IsFrozen()) {
+            return;
+        }
+        csr_offsets_.assign(vertex_count_ + 1, 0);
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            csr_offsets_[vertex + 1] = csr_offsets_[vertex] + incidence_lists_[vertex].size();
+        }
+        csr_edge_ids_.reserve(edges_.size());
+        csr_targets_.reserve(edges_.size());
+        csr_weights_.reserve(edges_.size());
+        for (const auto &incidence_list: incidence_lists_) {
+            for (const EdgeId edge_id: incidence_list) {
+                csr_edge_ids_.push_back(edge_id);
+                csr_targets_.push_back(edges_[edge_id].to);
+                csr_weights_.push_back(edges_[edge_id].weight);
+            }
+        }
+        // списки больше не нужны, освобождаем их память
+        std::vector<IncidenceList>().swap(incidence_lists_);
+    }
+
+    template<typename Weight>
+    void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+        if (edge_id >= edges_.size()) {
+            throw std::out_of_range("Edge id is out of range");
+        }
+        Edge<Weight> &edge = edges_[edge_id];
+        edge.weight = weight;
+        if (IsFrozen()) {
+            // копия веса в CSR-массиве среди исходящих ребер начальной вершины
+            for (size_t i = csr_offsets_[edge.from]; i < csr_offsets_[edge.from + 1]; ++i) {
+                if (csr_edge_ids_[i] == edge_id) {
+                    csr_weights_[i] = weight;
+                    break;
+                }
+            }
+        }
+    }
+
+    template<typename Weight>
+    bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+        return !csr_offsets_.empty();
+    }
+
     template<typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-        return incidence_lists_.size();  // Возвращение количества вершин в графе
+        return vertex_count_;  // Возвращение количества вершин в графе
     }
 
     template<typename Weight>
@@ -72,13 +185,38 @@ namespace graph {
 
     template<typename Weight>
     const Edge<Weight> &DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
-        return edges_.at(edge_id);  // Возвращение ребра по его идентификатору
+        return edges_[edge_id];  // Возвращение ребра по его идентификатору
     }
 
     template<typename Weight>
     typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
     DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-        return ranges::AsRange(incidence_lists_.at(vertex));  // Возвращение диапазона инцидентных ребер для указанной вершины
+        if (IsFrozen()) {
+            const EdgeId *data = csr_edge_ids_.data();
+            return {data + csr_offsets_[vertex], data + csr_offsets_[vertex + 1]};
+        }
+        const auto &incidence_list = incidence_lists_[vertex];
+        return {incidence_list.data(), incidence_list.data() + incidence_list.size()};  // Возвращение диапазона инцидентных ребер для указанной вершины
+    }
+
+    template<typename Weight>
+    typename DirectedWeightedGraph<Weight>::IncidentTargetsRange
+    DirectedWeightedGraph<Weight>::GetIncidentTargets(VertexId vertex) const {
+        if (!IsFrozen()) {
+            throw std::logic_error("Graph should be frozen");
+        }
+        const VertexId *data = csr_targets_.data();
+        return {data + csr_offsets_[vertex], data + csr_offsets_[vertex + 1]};
+    }
+
+    template<typename Weight>
+    typename DirectedWeightedGraph<Weight>::IncidentWeightsRange
+    DirectedWeightedGraph<Weight>::GetIncidentWeights(VertexId vertex) const {
+        if (!IsFrozen()) {
+            throw std::logic_error("Graph should be frozen");
+        }
+        const Weight *data = csr_weights_.data();
+        return {data + csr_offsets_[vertex], data + csr_offsets_[vertex + 1]};
     }
 
     template<typename Weight>
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace graph {
+
+    // Метки компонент связности вершин графа. Компоненты сильной связности пронумерованы алгоритмом Тарьяна
+    // в порядке завершения, поэтому ребро между разными компонентами всегда ведет в компоненту с меньшим номером;
+    // компоненты слабой связности - связность без учета направления ребер
+    struct ComponentLabels {
+        std::vector<uint32_t> strong;
+        std::vector<uint32_t> weak;
+
+        // false - маршрута from -> to точно нет; true - маршрут есть, если вершины в одной компоненте
+        // сильной связности, иначе ответ дает только поиск
+        bool MayReach(VertexId from, VertexId to) const {
+            return weak[from] == weak[to] && strong[from] >= strong[to];
+        }
+    };
+
+    // метки компонент графа за O(V + E): нерекурсивный алгоритм Тарьяна и система непересекающихся множеств
+    template<typename Weight>
+    ComponentLabels BuildComponentLabels(const DirectedWeightedGraph<Weight> &graph) {
+        constexpr uint32_t NO_INDEX = std::numeric_limits<uint32_t>::max();
+        const size_t vertex_count = graph.GetVertexCount();
+        ComponentLabels labels;
+        labels.strong.assign(vertex_count, NO_INDEX);
+
+        // порядок входа в вершину и наименьший порядок, достижимый из ее поддерева
+        std::vector<uint32_t> index(vertex_count, NO_INDEX);
+        std::vector<uint32_t> low(vertex_count);
+        std::vector<VertexId> stack;
+        // вызов обхода: вершина и позиция следующего ребра в списке ее ребер
+        std::vector<std::pair<VertexId, const EdgeId *>> calls;
+        uint32_t next_index = 0;
+        uint32_t component = 0;
+        const auto enter = [&](VertexId vertex) {
+            index[vertex] = low[vertex] = next_index++;
+            stack.push_back(vertex);
+            calls.emplace_back(vertex, graph.GetIncidentEdges(vertex).begin());
+        };
+        for (VertexId root = 0; root < vertex_count; ++root) {
+            if (index[root] != NO_INDEX) {
+                continue;
+            }
+            enter(root);
+            while (!calls.empty()) {
+                auto &[vertex, next_edge] = calls.back();
+                if (next_edge != graph.GetIncidentEdges(vertex).end()) {
+                    const VertexId to = graph.GetEdge(*next_edge++).to;
+                    if (index[to] == NO_INDEX) {
+                        enter(to);
+                    } else if (labels.strong[to] == NO_INDEX) {
+                        // to еще в стеке: его компонента не завершена
+                        low[vertex] = std::min(low[vertex], index[to]);
+                    }
+                    continue;
+                }
+                const VertexId done = vertex;
+                calls.pop_back();
+                if (!calls.empty()) {
+                    low[calls.back().first] = std::min(low[calls.back().first], low[done]);
+                }
+                if (low[done] == index[done]) {
+                    VertexId member;
+                    do {
+                        member = stack.back();
+                        stack.pop_back();
+                        labels.strong[member] = component;
+                    } while (member != done);
+                    ++component;
+                }
+            }
+        }
+
+        // слабая связность: множества склеиваются по ребрам, номер компоненты - по первой вершине множества
+        std::vector<VertexId> parents(vertex_count);
+        std::iota(parents.begin(), parents.end(), VertexId{0});
+        const auto find_root = [&parents](VertexId vertex) {
+            while (parents[vertex] != vertex) {
+                vertex = parents[vertex] = parents[parents[vertex]];
+            }
+            return vertex;
+        };
+        for (const auto &edge: graph.GetEdges()) {
+            const VertexId from_root = find_root(edge.from);
+            const VertexId to_root = find_root(edge.to);
+            if (from_root != to_root) {
+                parents[std::max(from_root, to_root)] = std::min(from_root, to_root);
+            }
+        }
+        labels.weak.assign(vertex_count, NO_INDEX);
+        uint32_t weak_component = 0;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            const VertexId root = find_root(vertex);
+            if (labels.weak[root] == NO_INDEX) {
+                labels.weak[root] = weak_component++;
+            }
+            labels.weak[vertex] = labels.weak[root];
+        }
+        return labels;
+    }
+
+}  // namespace graph
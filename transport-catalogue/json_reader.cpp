@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <ostream>
 #include <sstream>
+#include <unordered_map>
 #include "json_reader.h"
 
 namespace JsonReader {
@@ -31,11 +32,12 @@ namespace JsonReader {
             ParseRequestsRoutSett(std::move(map));
         }
         std::string path;
+        std::string router_table_path;
         if (auto it = main_map.find(MainReq::srlzt_settings); it != main_map.end()) {
             auto map = std::move(it->second.AsDict());
-            ParseRequestsSrlz(std::move(map), path);
+            ParseRequestsSrlz(std::move(map), path, router_table_path);
         }
-        req_hand_.CallSrlz(path);
+        req_hand_.CallSrlz(path, router_table_path);
     }
 
 //----------------------------------------------------------------------------
@@ -44,23 +46,34 @@ namespace JsonReader {
 
         auto main_map = std::move(json::Load(in).GetRoot().AsDict());
         std::string path;
+        std::string router_table_path;
         if (auto it = main_map.find(MainReq::srlzt_settings); it != main_map.end()) {
             auto map = std::move(it->second.AsDict());
-            ParseRequestsSrlz(std::move(map), path);
+            ParseRequestsSrlz(std::move(map), path, router_table_path);
+        }
+        req_hand_.CallDsrlz(path, router_table_path);
+        if (auto it = main_map.find(MainReq::update); it != main_map.end()) {
+            ExecRequestsUpdate(it->second.AsArray());
         }
-        req_hand_.CallDsrlz(path);
         if (auto it = main_map.find(MainReq::stat); it != main_map.end()) {
             auto vec_map = std::move(it->second.AsArray());
             ParseRequestsStat(vec_map);
         }
+        if (t_r_.GetRoutingSettings().route_cache_size > 0) {
+            std::cerr << "route cache: " << t_r_.GetRouteCacheHits() << " hits, "
+                      << t_r_.GetRouteCacheMisses() << " misses" << std::endl;
+        }
     }
 
 //----------------------------------------------------------------------------
-    void JsonReader::ParseRequestsSrlz(const json::Dict &&req, std::string &path) {
+    void JsonReader::ParseRequestsSrlz(const json::Dict &&req, std::string &path, std::string &router_table_path) {
         using namespace domain;
         if (req.find(MainReq::file) != req.end()) {
             path = std::move(req.at(MainReq::file).AsString());
         }
+        if (req.find(MainReq::router_table_file) != req.end()) {
+            router_table_path = req.at(MainReq::router_table_file).AsString();
+        }
     }
 
 //----------------------------------------------------------------------------
@@ -105,19 +118,91 @@ namespace JsonReader {
             request.type = std::move(cur_req.at(type).AsString());
             if (request.type == bus || request.type == stop) {
                 request.name = std::move(cur_req.at(name).AsString());
+            } else if (request.type == reachable) {
+                request.name = std::move(cur_req.at(name).AsString());
+                request.max_time = cur_req.at(max_time).AsDouble();
             } else if (request.type == route) {
                 request.name = std::move(cur_req.at(from).AsString());
                 request.name_to = std::move(cur_req.at(to).AsString());
+                if (const auto it = cur_req.find(departure_time); it != cur_req.end()) {
+                    request.departure_time = it->second.AsDouble();
+                }
+            } else if (request.type == routes) {
+                request.name = std::move(cur_req.at(from).AsString());
+                request.name_to = std::move(cur_req.at(to).AsString());
+                if (const auto it = cur_req.find(count); it != cur_req.end()) {
+                    // count < 1 - пустой ответ, больше MAX_ROUTES_COUNT маршрутов не ищется
+                    request.count = static_cast<size_t>(std::clamp(it->second.AsInt(), 0, MAX_ROUTES_COUNT));
+                }
+            } else if (request.type == time_matrix) {
+                for (const auto &stop_name: cur_req.at(from).AsArray()) {
+                    request.names_from.push_back(stop_name.AsString());
+                }
+                for (const auto &stop_name: cur_req.at(to).AsArray()) {
+                    request.names_to.push_back(stop_name.AsString());
+                }
             }
             requests.emplace_back(std::move(request));
         }
         ExecRequestsStat(std::move(requests));
     }
 
+//----------------------------------------------------------------------------
+    void JsonReader::ExecRequestsUpdate(const json::Array &vec_map) {
+        using namespace domain;
+        using namespace MainReq;
+        for (const auto &req: vec_map) {
+            const auto &cur_req = req.AsDict();
+            const std::string &req_type = cur_req.at(type).AsString();
+            if (req_type == distance) {
+                if (!req_hand_.UpdateDistance(cur_req.at(from).AsString(), cur_req.at(to).AsString(),
+                                              static_cast<size_t>(cur_req.at(distance_value).AsInt()))) {
+                    std::cerr << "update: unknown stop" << std::endl;
+                }
+            } else if (req_type == bus) {
+                req_hand_.AddBus(ParseRequestsBuses(cur_req));
+            } else if (req_type == remove_bus) {
+                if (!req_hand_.RemoveBus(cur_req.at(name).AsString())) {
+                    std::cerr << "update: unknown bus " << cur_req.at(name).AsString() << std::endl;
+                }
+            } else {
+                std::cerr << "update: unknown type " << req_type << std::endl;
+            }
+        }
+    }
+
 //----------------------------------------------------------------------------
     void JsonReader::ExecRequestsStat(std::vector<domain::RequestOut> &&requests) {
+        // запросы Route группируются по начальной остановке: на группу - один пакетный запрос маршрутов;
+        // запросы со временем отправления считаются по расписанию отдельно
+        std::unordered_map<std::string_view, std::vector<size_t>> route_groups;
+        std::vector<domain::RoutStatPtr> route_stats(requests.size());
+        for (size_t i = 0; i < requests.size(); ++i) {
+            if (requests[i].type != domain::MainReq::route) {
+                continue;
+            }
+            if (requests[i].departure_time) {
+                route_stats[i] = req_hand_.GetTimetableRouteStat(requests[i].name, requests[i].name_to.value(),
+                                                                 *requests[i].departure_time);
+            } else {
+                route_groups[requests[i].name].push_back(i);
+            }
+        }
+        for (const auto &[stop_from, indexes]: route_groups) {
+            std::vector<std::string_view> stops_to;
+            stops_to.reserve(indexes.size());
+            for (const size_t index: indexes) {
+                stops_to.push_back(requests[index].name_to.value());
+            }
+            auto group_stats = req_hand_.GetRouteStats(stop_from, stops_to);
+            for (size_t i = 0; i < indexes.size(); ++i) {
+                route_stats[indexes[i]] = std::move(group_stats[i]);
+            }
+        }
+
         json::Array vec;
-        for (const auto &req: requests) {
+        for (size_t i = 0; i < requests.size(); ++i) {
+            const auto &req = requests[i];
             if (req.type == domain::MainReq::stop) {
                 vec.emplace_back(PrintResReqStop(req_hand_.GetBusesByStop(req.name), req.id));
             } else if (req.type == domain::MainReq::bus) {
@@ -125,7 +210,14 @@ namespace JsonReader {
             } else if (req.type == domain::MainReq::map) {
                 vec.emplace_back(PrintResReqMap(req_hand_.RenderMap(), req.id));
             } else if (req.type == domain::MainReq::route) {
-                vec.emplace_back(PrintResReqRoute(req_hand_.GetRouteStat(req.name, req.name_to.value()), req.id));
+                vec.emplace_back(PrintResReqRoute(route_stats[i], req.id));
+            } else if (req.type == domain::MainReq::time_matrix) {
+                vec.emplace_back(PrintResReqTimeMatrix(req_hand_.GetTimeMatrix(req.names_from, req.names_to), req.id));
+            } else if (req.type == domain::MainReq::routes) {
+                vec.emplace_back(PrintResReqRoutes(req_hand_.GetAlternativeRouteStats(req.name, req.name_to.value(),
+                                                                                      req.count), req.id));
+            } else if (req.type == domain::MainReq::reachable) {
+                vec.emplace_back(PrintResReqReachable(req_hand_.GetReachableStops(req.name, req.max_time), req.id));
             }
         }
         json::Print(json::Document{json::Node{vec}}, std::cout);
@@ -226,6 +318,62 @@ namespace JsonReader {
             if (req.find(bus_velocity) != req.end()) {
                 rout_set.bus_velocity = req.at(bus_velocity).AsDouble();
             }
+            if (req.find(router) != req.end()) {
+                const std::string &router_type = req.at(router).AsString();
+                if (router_type == router_dijkstra) {
+                    rout_set.router_type = RouterType::Dijkstra;
+                } else if (router_type == router_contraction_hierarchy) {
+                    rout_set.router_type = RouterType::ContractionHierarchy;
+                } else if (router_type == router_a_star) {
+                    rout_set.router_type = RouterType::AStar;
+                } else if (router_type == router_bidirectional) {
+                    rout_set.router_type = RouterType::Bidirectional;
+                } else if (router_type == router_all_pairs) {
+                    rout_set.router_type = RouterType::AllPairs;
+                } else {
+                    std::cerr << "unknown router type: " << router_type << std::endl;
+                }
+            }
+            if (req.find(store_router_table) != req.end()) {
+                rout_set.store_router_table = req.at(store_router_table).AsBool();
+            }
+            if (req.find(graph_model) != req.end()) {
+                const std::string &model = req.at(graph_model).AsString();
+                if (model == graph_model_linear) {
+                    rout_set.graph_model = GraphModel::Linear;
+                } else if (model == graph_model_complete) {
+                    rout_set.graph_model = GraphModel::Complete;
+                } else {
+                    std::cerr << "unknown graph model: " << model << std::endl;
+                }
+            }
+            if (req.find(route_cache_size) != req.end()) {
+                rout_set.route_cache_size = static_cast<size_t>(req.at(route_cache_size).AsInt());
+            }
+            if (req.find(stop_order) != req.end()) {
+                const std::string &order = req.at(stop_order).AsString();
+                if (order == stop_order_hilbert) {
+                    rout_set.stop_order = StopOrder::Hilbert;
+                } else if (order == stop_order_bfs) {
+                    rout_set.stop_order = StopOrder::Bfs;
+                } else if (order == stop_order_input) {
+                    rout_set.stop_order = StopOrder::Input;
+                } else {
+                    std::cerr << "unknown stop order: " << order << std::endl;
+                }
+            }
+            if (req.find(all_pairs_table) != req.end()) {
+                const std::string &table = req.at(all_pairs_table).AsString();
+                if (table == all_pairs_table_next_hop) {
+                    rout_set.all_pairs_table = AllPairsTable::NextHop;
+                } else if (table == all_pairs_table_next_hop_runs) {
+                    rout_set.all_pairs_table = AllPairsTable::NextHopRuns;
+                } else if (table == all_pairs_table_prev_edges) {
+                    rout_set.all_pairs_table = AllPairsTable::PrevEdges;
+                } else {
+                    std::cerr << "unknown all pairs table: " << table << std::endl;
+                }
+            }
             t_r_.vInit(std::move(rout_set), t_c_);
         } catch (...) {
             std::cout << "ParseRequestsRoutSett FAIL" << std::endl;
@@ -268,7 +416,25 @@ namespace JsonReader {
                         stops.push_back(*it);
                     }
                 }
-                return {req.at(MainReq::name).AsString(), move(stops), req.at(MainReq::is_roundtrip).AsBool()};
+                std::vector<double> departures;
+                if (const auto it = req.find(MainReq::departures); it != req.end()) {
+                    for (const auto &departure: it->second.AsArray()) {
+                        departures.push_back(departure.AsDouble());
+                    }
+                } else if (const auto it_headway = req.find(MainReq::headway); it_headway != req.end()) {
+                    // рейсы с интервалом headway от первого до последнего отправления
+                    const double headway = it_headway->second.AsDouble();
+                    const auto it_first = req.find(MainReq::first_departure);
+                    const auto it_last = req.find(MainReq::last_departure);
+                    const double first = it_first != req.end() ? it_first->second.AsDouble() : 0.;
+                    const double last = it_last != req.end() ? it_last->second.AsDouble() : 24. * 60.;
+                    for (size_t i = 0; headway > 0 && first + i * headway <= last; ++i) {
+                        departures.push_back(first + i * headway);
+                    }
+                }
+                std::sort(departures.begin(), departures.end());
+                return {req.at(MainReq::name).AsString(), move(stops), req.at(MainReq::is_roundtrip).AsBool(),
+                        move(departures)};
             } catch (...) {
                 std::cout << "Fail Bus" << std::endl;
                 throw;
@@ -345,34 +511,95 @@ namespace JsonReader {
     }
 
 //----------------------------------------------------------------------------
-    json::Dict JsonReader::PrintResReqRoute(std::optional<domain::RoutStat> &&rout_stat_opt, int id) {
-        using namespace domain;
-        using TransportCatalogue::RoutStat;
-        if (!rout_stat_opt) {
+    json::Dict JsonReader::PrintResReqRoute(const domain::RoutStatPtr &rout_stat_ptr, int id) {
+        if (!rout_stat_ptr) {
+            return json::Builder{}.StartDict().Key("request_id"s).Value(id)
+                    .Key("error_message"s).Value("not found"s).EndDict().Build().AsDict();
+        }
+
+        return json::Builder{}.StartDict().Key("items"s).Value(PrintRouteItems(*rout_stat_ptr))
+                .Key("total_time"s).Value(rout_stat_ptr->total_time)
+                .Key("request_id"s).Value(id).EndDict().Build().AsDict();
+    }
+
+//----------------------------------------------------------------------------
+    json::Dict JsonReader::PrintResReqRoutes(std::optional<std::vector<domain::RoutStatPtr>> &&rout_stats_opt, int id) {
+        if (!rout_stats_opt || rout_stats_opt->empty()) {
             return json::Builder{}.StartDict().Key("request_id"s).Value(id)
                     .Key("error_message"s).Value("not found"s).EndDict().Build().AsDict();
         }
 
-        const auto &rout_stat = *rout_stat_opt;
+        json::Array routes;
+        routes.reserve(rout_stats_opt->size());
+        for (const auto &rout_stat_ptr: *rout_stats_opt) {
+            routes.emplace_back(json::Dict{{"items"s,      PrintRouteItems(*rout_stat_ptr)},
+                                           {"total_time"s, rout_stat_ptr->total_time}});
+        }
+        return json::Builder{}.StartDict().Key("routes"s).Value(std::move(routes))
+                .Key("request_id"s).Value(id).EndDict().Build().AsDict();
+    }
+
+//----------------------------------------------------------------------------
+    json::Array JsonReader::PrintRouteItems(const domain::RoutStat &rout_stat) {
+        using namespace domain;
+        using TransportCatalogue::RoutStat;
         json::Array vec;
-        for (const RoutStat::VariantItem &item: rout_stat.items) {
+        vec.reserve(rout_stat.items.size());
+        for (const RoutStat::Item &item: rout_stat.items) {
             json::Dict dict;
-            if (std::holds_alternative<RoutStat::ItemsWait>(item)) {
-                auto it = std::get<RoutStat::ItemsWait>(item);
-                dict.insert({"stop_name"s, it.stop_name});
-                dict.insert({"time"s, it.time});
-                dict.insert({"type"s, it.type});
-            } else if (std::holds_alternative<RoutStat::ItemsBus>(item)) {
-                auto it = std::get<RoutStat::ItemsBus>(item);
-                dict.insert({"bus"s, it.bus});
-                dict.insert({"span_count"s, static_cast<int>(it.span_count)});
-                dict.insert({"time"s, it.time});
-                dict.insert({"type"s, it.type});
+            // имена остановок и автобусов берутся из таблиц маршрутизатора по номеру
+            const std::string name(t_r_.GetItemName(item));
+            if (item.type == RoutStat::ItemType::Wait) {
+                dict.insert({"stop_name"s, name});
+                dict.insert({"time"s, item.time});
+                dict.insert({"type"s, "Wait"s});
+            } else {
+                dict.insert({"bus"s, name});
+                dict.insert({"span_count"s, static_cast<int>(item.span_count)});
+                dict.insert({"time"s, item.time});
+                dict.insert({"type"s, "Bus"s});
+            }
+            vec.push_back(std::move(dict));
+        }
+        return vec;
+    }
+
+//----------------------------------------------------------------------------
+    json::Dict JsonReader::PrintResReqTimeMatrix(std::optional<domain::TimeMatrix> &&time_matrix_opt, int id) {
+        if (!time_matrix_opt) {
+            return json::Builder{}.StartDict().Key("request_id"s).Value(id)
+                    .Key("error_message"s).Value("not found"s).EndDict().Build().AsDict();
+        }
+
+        json::Array rows;
+        rows.reserve(time_matrix_opt->size());
+        for (const auto &row: *time_matrix_opt) {
+            json::Array times;
+            times.reserve(row.size());
+            for (const auto &time: row) {
+                // отсутствующий маршрут - null
+                times.emplace_back(time ? json::Node(*time) : json::Node(nullptr));
             }
-            vec.push_back(dict);
+            rows.emplace_back(std::move(times));
+        }
+        return json::Builder{}.StartDict().Key("times"s).Value(std::move(rows))
+                .Key("request_id"s).Value(id).EndDict().Build().AsDict();
+    }
+//----------------------------------------------------------------------------
+    json::Dict JsonReader::PrintResReqReachable(std::optional<std::vector<domain::ReachableStop>> &&stops_opt,
+                                                int id) {
+        if (!stops_opt) {
+            return json::Builder{}.StartDict().Key("request_id"s).Value(id)
+                    .Key("error_message"s).Value("not found"s).EndDict().Build().AsDict();
+        }
+
+        json::Array stops;
+        stops.reserve(stops_opt->size());
+        for (const auto &[stop_name, time]: *stops_opt) {
+            stops.emplace_back(json::Dict{{"stop_name"s, std::string(stop_name)},
+                                          {"time"s,      time}});
         }
-        return json::Builder{}.StartDict().Key("items"s).Value(vec)
-                .Key("total_time"s).Value(rout_stat.total_time)
+        return json::Builder{}.StartDict().Key("stops"s).Value(std::move(stops))
                 .Key("request_id"s).Value(id).EndDict().Build().AsDict();
     }
 //----------------------------------------------------------------------------
@@ -22,11 +22,11 @@ namespace JsonReader {
         /** обработка .json с вводными данными из которых сформируется БД */
         void ParseJsonMakeBase(std::istream &in);
 
-        /** обработка .json с запросами к готовой БД */
+        /** обработка .json с запросами к готовой БД; при включенном кэше маршрутов его счетчики пишутся в cerr */
         void ParseJsonProcessRequests(std::istream &in);
 
     private:
-        void ParseRequestsSrlz(const json::Dict &&req, std::string &path);
+        void ParseRequestsSrlz(const json::Dict &&req, std::string &path, std::string &router_table_path);
 
         void ParseRequestsBase(json::Array &&vec_map);
 
@@ -40,6 +40,9 @@ namespace JsonReader {
 
         void ExecRequestsStat(std::vector<domain::RequestOut> &&requests);
 
+        // изменения расстояний и автобусов, применяются к загруженной базе до запросов stat_requests
+        void ExecRequestsUpdate(const json::Array &vec_map);
+
         void ParseRequestsRendSett(const json::Dict &&map);
 
         void ParseRequestsRoutSett(const json::Dict &&req);
@@ -50,7 +53,16 @@ namespace JsonReader {
 
         json::Dict PrintResReqMap(std::optional<svg::Document> &&doc_opt, int id);
 
-        json::Dict PrintResReqRoute(std::optional<domain::RoutStat> &&rout_stat_opt, int id);
+        json::Dict PrintResReqRoute(const domain::RoutStatPtr &rout_stat_ptr, int id);
+
+        json::Dict PrintResReqRoutes(std::optional<std::vector<domain::RoutStatPtr>> &&rout_stats_opt, int id);
+
+        // элементы маршрута (ожидания и поездки) в формате ответа на запрос Route
+        json::Array PrintRouteItems(const domain::RoutStat &rout_stat);
+
+        json::Dict PrintResReqTimeMatrix(std::optional<domain::TimeMatrix> &&time_matrix_opt, int id);
+
+        json::Dict PrintResReqReachable(std::optional<std::vector<domain::ReachableStop>> &&stops_opt, int id);
 
         TransportCatalogue::TransportCatalogue &t_c_;
 
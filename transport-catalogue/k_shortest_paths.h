@@ -0,0 +1,250 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_data.h"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // поиск k кратчайших простых (без повторения вершин) маршрутов алгоритмом Йена.
+    // Каждый следующий маршрут ищется как отклонение от уже найденных: для каждой вершины
+    // предыдущего маршрута запрещаются ребра, по которым из этой вершины уходят маршруты
+    // с тем же началом, и вершины начала, после чего от нее ищется кратчайший остаток пути
+    template<typename Weight>
+    class KShortestPaths {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+
+        explicit KShortestPaths(const Graph &graph);
+
+        // до count маршрутов по возрастанию веса
+        std::vector<RouteInfo> BuildRoutes(VertexId from, VertexId to, size_t count) const;
+
+        // то же, но маршруты с равными ключами route_key(edges) считаются одним, например маршруты
+        // по параллельным ребрам с одинаковым описанием; в ответ попадает самый легкий из них
+        template<typename RouteKey>
+        std::vector<RouteInfo> BuildRoutes(VertexId from, VertexId to, size_t count, RouteKey route_key) const;
+
+    private:
+        // запреты для поиска остатка пути
+        struct Restrictions {
+            std::vector<char> banned_vertices;
+            std::vector<char> banned_edges;
+        };
+
+        // кратчайший маршрут from -> to в обход запрещенных вершин и ребер;
+        // поиск прекращается, когда вес в очереди превышает max_weight
+        std::optional<RouteInfo> BuildRestrictedRoute(VertexId from, VertexId to, const Restrictions &restrictions,
+                                                      Weight max_weight) const;
+
+        // вес маршрута, сложенный по ребрам в порядке следования, как в BuildRoute маршрутизаторов
+        Weight SumWeight(const std::vector<EdgeId> &edges) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr EdgeId NO_EDGE = SearchData<Weight>::NO_EDGE;
+        const Graph &graph_;
+    };
+
+    template<typename Weight>
+    KShortestPaths<Weight>::KShortestPaths(const Graph &graph)
+            : graph_(graph) {
+        if (!graph.IsFrozen()) {
+            throw std::logic_error("Graph should be frozen");
+        }
+    }
+
+    template<typename Weight>
+    std::vector<typename KShortestPaths<Weight>::RouteInfo>
+    KShortestPaths<Weight>::BuildRoutes(VertexId from, VertexId to, size_t count) const {
+        return BuildRoutes(from, to, count, [](const std::vector<EdgeId> &edges) -> const std::vector<EdgeId> & {
+            return edges;
+        });
+    }
+
+    template<typename Weight>
+    template<typename RouteKey>
+    std::vector<typename KShortestPaths<Weight>::RouteInfo>
+    KShortestPaths<Weight>::BuildRoutes(VertexId from, VertexId to, size_t count, RouteKey route_key) const {
+        using Key = std::decay_t<decltype(route_key(std::declval<const std::vector<EdgeId> &>()))>;
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        // найденные маршруты, в том числе с повторяющимися ключами: от всех них ищутся отклонения
+        std::vector<RouteInfo> routes;
+        // ответ - маршруты с разными ключами
+        std::vector<RouteInfo> distinct_routes;
+        std::vector<Key> distinct_keys;
+        if (count == 0) {
+            return distinct_routes;
+        }
+        // запреты переиспользуются между запросами потока и после каждого запроса снова пусты
+        static thread_local Restrictions restrictions;
+        if (restrictions.banned_vertices.size() < vertex_count) {
+            restrictions.banned_vertices.resize(vertex_count, 0);
+        }
+        if (restrictions.banned_edges.size() < graph_.GetEdgeCount()) {
+            restrictions.banned_edges.resize(graph_.GetEdgeCount(), 0);
+        }
+        constexpr Weight no_limit = std::numeric_limits<Weight>::has_infinity
+                                    ? std::numeric_limits<Weight>::infinity()
+                                    : std::numeric_limits<Weight>::max();
+        auto first_route = BuildRestrictedRoute(from, to, restrictions, no_limit);
+        if (!first_route) {
+            return distinct_routes;
+        }
+        const auto accept_route = [&](RouteInfo &&route) {
+            Key key = route_key(route.edges);
+            if (std::find(distinct_keys.begin(), distinct_keys.end(), key) == distinct_keys.end()) {
+                distinct_keys.push_back(std::move(key));
+                distinct_routes.push_back(route);
+            }
+            routes.push_back(std::move(route));
+        };
+        accept_route(std::move(*first_route));
+
+        // кандидаты на следующий маршрут
+        std::vector<RouteInfo> candidates;
+        const auto is_known = [&](const std::vector<EdgeId> &edges) {
+            const auto same_edges = [&edges](const RouteInfo &route) {
+                return route.edges == edges;
+            };
+            return std::any_of(routes.begin(), routes.end(), same_edges)
+                   || std::any_of(candidates.begin(), candidates.end(), same_edges);
+        };
+        const auto route_less = [](const RouteInfo &lhs, const RouteInfo &rhs) {
+            return lhs.weight < rhs.weight || (!(rhs.weight < lhs.weight) && lhs.edges < rhs.edges);
+        };
+
+        while (distinct_routes.size() < count) {
+            const std::vector<EdgeId> &last_edges = routes.back().edges;
+            // отсечение: если кандидатов с новыми ключами уже хватает до count, остаток пути тяжелее худшего
+            // из нужных не нужен
+            Weight limit = no_limit;
+            if (const size_t needed = count - distinct_routes.size(); candidates.size() >= needed) {
+                std::sort(candidates.begin(), candidates.end(), route_less);
+                std::vector<Key> new_keys;
+                for (const RouteInfo &candidate: candidates) {
+                    Key key = route_key(candidate.edges);
+                    if (std::find(distinct_keys.begin(), distinct_keys.end(), key) != distinct_keys.end()
+                        || std::find(new_keys.begin(), new_keys.end(), key) != new_keys.end()) {
+                        continue;
+                    }
+                    new_keys.push_back(std::move(key));
+                    if (new_keys.size() == needed) {
+                        limit = candidate.weight;
+                        break;
+                    }
+                }
+            }
+
+            VertexId spur_vertex = from;
+            Weight root_weight = ZERO_WEIGHT;
+            for (size_t i = 0; i < last_edges.size(); ++i) {
+                // ребра из вершины отклонения, по которым уходят найденные маршруты с тем же началом
+                for (const RouteInfo &route: routes) {
+                    if (route.edges.size() > i && std::equal(last_edges.begin(), last_edges.begin() + i,
+                                                             route.edges.begin())) {
+                        restrictions.banned_edges[route.edges[i]] = 1;
+                    }
+                }
+                if (!(limit < root_weight)) {
+                    auto spur_route = BuildRestrictedRoute(spur_vertex, to, restrictions, limit - root_weight);
+                    if (spur_route) {
+                        std::vector<EdgeId> edges(last_edges.begin(), last_edges.begin() + i);
+                        edges.insert(edges.end(), spur_route->edges.begin(), spur_route->edges.end());
+                        if (!is_known(edges)) {
+                            candidates.push_back(RouteInfo{SumWeight(edges), std::move(edges)});
+                        }
+                    }
+                }
+                for (const RouteInfo &route: routes) {
+                    if (route.edges.size() > i) {
+                        restrictions.banned_edges[route.edges[i]] = 0;
+                    }
+                }
+                // вершина отклонения становится частью начала и запрещается для следующих отклонений
+                restrictions.banned_vertices[spur_vertex] = 1;
+                const auto &edge = graph_.GetEdge(last_edges[i]);
+                root_weight += edge.weight;
+                spur_vertex = edge.to;
+            }
+            restrictions.banned_vertices[from] = 0;
+            for (size_t i = 0; i + 1 < last_edges.size(); ++i) {
+                restrictions.banned_vertices[graph_.GetEdge(last_edges[i]).to] = 0;
+            }
+
+            if (candidates.empty()) {
+                break;
+            }
+            const auto best = std::min_element(candidates.begin(), candidates.end(), route_less);
+            RouteInfo best_route = std::move(*best);
+            candidates.erase(best);
+            accept_route(std::move(best_route));
+        }
+        return distinct_routes;
+    }
+
+    template<typename Weight>
+    std::optional<typename KShortestPaths<Weight>::RouteInfo>
+    KShortestPaths<Weight>::BuildRestrictedRoute(VertexId from, VertexId to, const Restrictions &restrictions,
+                                                 Weight max_weight) const {
+        SearchData<Weight> &data = GetThreadSearchData<Weight>(SearchSlot::Auxiliary);
+        data.Prepare(graph_.GetVertexCount());
+        data.Reach(from, ZERO_WEIGHT, NO_EDGE);
+
+        while (!data.heap.empty()) {
+            const auto [weight, vertex] = data.Pop();
+            if (data.weights[vertex] < weight) {
+                continue;  // устаревшая запись очереди
+            }
+            if (vertex == to || max_weight < weight) {
+                break;
+            }
+            const auto edge_ids = graph_.GetIncidentEdges(vertex);
+            const VertexId *targets = graph_.GetIncidentTargets(vertex).begin();
+            const Weight *edge_weights = graph_.GetIncidentWeights(vertex).begin();
+            for (size_t i = 0, count = edge_ids.end() - edge_ids.begin(); i < count; ++i) {
+                if (restrictions.banned_edges[edge_ids.begin()[i]] || restrictions.banned_vertices[targets[i]]) {
+                    continue;
+                }
+                const Weight candidate_weight = weight + edge_weights[i];
+                if (!data.IsReached(targets[i]) || candidate_weight < data.weights[targets[i]]) {
+                    data.Reach(targets[i], candidate_weight, edge_ids.begin()[i]);
+                }
+            }
+        }
+
+        if (!data.IsReached(to) || max_weight < data.weights[to]) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (EdgeId edge_id = data.prev_edges[to]; edge_id != NO_EDGE;
+             edge_id = data.prev_edges[graph_.GetEdge(edge_id).from]) {
+            edges.push_back(edge_id);
+        }
+        std::reverse(edges.begin(), edges.end());
+        return RouteInfo{data.weights[to], std::move(edges)};
+    }
+
+    template<typename Weight>
+    Weight KShortestPaths<Weight>::SumWeight(const std::vector<EdgeId> &edges) const {
+        Weight weight = ZERO_WEIGHT;
+        for (const EdgeId edge_id: edges) {
+            weight += graph_.GetEdge(edge_id).weight;
+        }
+        return weight;
+    }
+
+}  // namespace graph
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cache {
+
+    // ограниченный кэш с вытеснением давно не использованных записей (LRU).
+    // Ключи распределены по сегментам со своими мьютексами, поэтому обращения из разных потоков
+    // к разным сегментам не блокируют друг друга. Value должен дешево копироваться (например, shared_ptr).
+    template<typename Key, typename Value, typename Hash = std::hash<Key>>
+    class LruCache {
+    public:
+        explicit LruCache(size_t capacity, size_t shard_count = 16)
+                : shards_(std::max<size_t>(1, std::min(shard_count, capacity))) {
+            // сумма емкостей сегментов равна capacity: остаток деления достается первым сегментам.
+            // Сегментов не больше capacity, поэтому при ненулевой capacity у каждого емкость не меньше 1
+            const size_t shard_capacity = capacity / shards_.size();
+            const size_t remainder = capacity % shards_.size();
+            for (size_t i = 0; i < shards_.size(); ++i) {
+                shards_[i].capacity = shard_capacity + (i < remainder ? 1 : 0);
+            }
+        }
+
+        // значение по ключу; найденная запись становится самой свежей
+        std::optional<Value> Get(const Key &key) {
+            Shard &shard = GetShard(key);
+            std::lock_guard lock(shard.mutex);
+            const auto it = shard.index.find(key);
+            if (it == shard.index.end()) {
+                ++misses_;
+                return std::nullopt;
+            }
+            shard.items.splice(shard.items.begin(), shard.items, it->second);
+            ++hits_;
+            return it->second->second;
+        }
+
+        // добавляет или обновляет запись, при переполнении сегмента вытесняет самую старую
+        void Put(const Key &key, Value value) {
+            Shard &shard = GetShard(key);
+            if (shard.capacity == 0) {
+                return;
+            }
+            std::lock_guard lock(shard.mutex);
+            if (const auto it = shard.index.find(key); it != shard.index.end()) {
+                it->second->second = std::move(value);
+                shard.items.splice(shard.items.begin(), shard.items, it->second);
+                return;
+            }
+            if (shard.items.size() >= shard.capacity) {
+                shard.index.erase(shard.items.back().first);
+                shard.items.pop_back();
+            }
+            shard.items.emplace_front(key, std::move(value));
+            shard.index.emplace(key, shard.items.begin());
+        }
+
+        void Clear() {
+            for (Shard &shard: shards_) {
+                std::lock_guard lock(shard.mutex);
+                shard.index.clear();
+                shard.items.clear();
+            }
+        }
+
+        size_t GetHits() const {
+            return hits_;
+        }
+
+        size_t GetMisses() const {
+            return misses_;
+        }
+
+    private:
+        struct Shard {
+            std::mutex mutex;
+            size_t capacity = 0;
+            std::list<std::pair<Key, Value>> items;  // от самой свежей записи к самой старой
+            std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator, Hash> index;
+        };
+
+        Shard &GetShard(const Key &key) {
+            // перемешивание, чтобы сегмент не определялся теми же битами, что и корзина внутри сегмента
+            const uint64_t hash = static_cast<uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull;
+            return shards_[(hash >> 32) % shards_.size()];
+        }
+
+        std::vector<Shard> shards_;
+        std::atomic<size_t> hits_ = 0;
+        std::atomic<size_t> misses_ = 0;
+    };
+
+}  // namespace cache
@@ -0,0 +1,51 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//----------------------------------------------------------------------------
+std::shared_ptr<const MappedFile> MappedFile::Open(const std::filesystem::path &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("MappedFile: can't open " + path.string());
+    }
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("MappedFile: can't get size of " + path.string());
+    }
+    const auto size = static_cast<size_t>(file_stat.st_size);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    // отображение остается действительным и после закрытия дескриптора
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("MappedFile: can't map " + path.string());
+    }
+    // обращения к таблице маршрутов точечные, упреждающее чтение соседних страниц не нужно
+    madvise(data, size, MADV_RANDOM);
+    return std::shared_ptr<const MappedFile>(new MappedFile(data, size));
+}
+
+//----------------------------------------------------------------------------
+MappedFile::MappedFile(void *data, size_t size)
+        : data_(data), size_(size) {
+}
+
+//----------------------------------------------------------------------------
+MappedFile::~MappedFile() {
+    munmap(data_, size_);
+}
+
+//----------------------------------------------------------------------------
+const std::byte *MappedFile::GetData() const {
+    return static_cast<const std::byte *>(data_);
+}
+
+//----------------------------------------------------------------------------
+size_t MappedFile::GetSize() const {
+    return size_;
+}
+//----------------------------------------------------------------------------
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+
+// файл, отображенный в память только для чтения; страницы подгружаются ОС по мере обращения
+// и разделяются между процессами, отобразившими тот же файл
+class MappedFile {
+public:
+    // бросает std::runtime_error, если файл не удалось открыть или отобразить
+    static std::shared_ptr<const MappedFile> Open(const std::filesystem::path &path);
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile();
+
+    const std::byte *GetData() const;
+
+    size_t GetSize() const;
+
+private:
+    MappedFile(void *data, size_t size);
+
+    void *data_ = nullptr;
+    size_t size_ = 0;
+};
@@ -0,0 +1,261 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_data.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Таблица первых шагов кратчайших маршрутов всех пар: в ячейке (from, to) - позиция первого ребра маршрута
+    // в списке исходящих ребер from. Ячейка занимает hop_width байт (1, 2 или 4) - наименьшую ширину, в которую
+    // помещается наибольшая степень вершины; наибольшее значение ширины - признак отсутствия маршрута.
+    // При сжатии серий строка хранится сериями одинаковых ячеек подряд идущих to
+    struct NextHopTable {
+        size_t vertex_count = 0;
+        uint32_t hop_width = 1;
+        // ячейки по hop_width байт: без сжатия - vertex_count * vertex_count ячеек,
+        // со сжатием - значения серий всех строк подряд
+        std::vector<uint8_t> hops;
+        // только при сжатии: серии строки from - [row_offsets[from], row_offsets[from + 1]),
+        // run_starts - первый to каждой серии
+        std::vector<uint32_t> row_offsets;
+        std::vector<uint32_t> run_starts;
+
+        bool HasRuns() const {
+            return !row_offsets.empty();
+        }
+
+        // признак отсутствия маршрута для ширины ячейки
+        uint32_t GetNoHop() const {
+            return hop_width == 4 ? UINT32_MAX : (1u << (8 * hop_width)) - 1;
+        }
+
+        // размер таблицы в байтах
+        size_t GetByteSize() const {
+            return hops.size() + (row_offsets.size() + run_starts.size()) * sizeof(uint32_t);
+        }
+    };
+
+    // маршрутизатор по таблице первых шагов: маршрут восстанавливается от начала, шаг за шагом по таблице,
+    // за время, линейное по длине маршрута (со сжатием серий - с двоичным поиском серии на шаге).
+    // Веса маршрутов не хранятся и считаются по ребрам графа
+    template<typename Weight>
+    class NextHopRouter : public RouterBase<Weight> {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        NextHopRouter(const Graph &graph, NextHopTable &&table);
+
+        std::optional<Weight> BuildRoutePath(VertexId from, VertexId to, std::vector<EdgeId> &edges) const override;
+
+        const NextHopTable &GetTable() const;
+
+    private:
+        uint32_t ReadHop(size_t index) const {
+            const uint8_t *cell = table_.hops.data() + index * table_.hop_width;
+            switch (table_.hop_width) {
+                case 1:
+                    return *cell;
+                case 2: {
+                    uint16_t hop;
+                    std::memcpy(&hop, cell, sizeof(hop));
+                    return hop;
+                }
+                default: {
+                    uint32_t hop;
+                    std::memcpy(&hop, cell, sizeof(hop));
+                    return hop;
+                }
+            }
+        }
+
+        uint32_t GetHop(VertexId from, VertexId to) const {
+            if (!table_.HasRuns()) {
+                return ReadHop(from * table_.vertex_count + to);
+            }
+            // серия, в которую попадает to: последняя серия строки, начинающаяся не позже to
+            const auto first = table_.run_starts.begin() + table_.row_offsets[from];
+            const auto last = table_.run_starts.begin() + table_.row_offsets[from + 1];
+            const auto run = std::upper_bound(first, last, static_cast<uint32_t>(to)) - 1;
+            return ReadHop(run - table_.run_starts.begin());
+        }
+
+        static constexpr Weight ZERO_WEIGHT{};
+        const Graph &graph_;
+        NextHopTable table_;
+        uint32_t no_hop_;
+    };
+
+    // строит таблицу первых шагов: для каждой конечной вершины - дерево кратчайших маршрутов в нее поиском
+    // Дейкстры по обратным ребрам, шаг вершины - ребро к ее родителю в дереве. Шаги одного столбца образуют
+    // дерево, поэтому проход по таблице не зацикливается и при ребрах нулевого веса
+    template<typename Weight>
+    NextHopTable BuildNextHopTable(const DirectedWeightedGraph<Weight> &graph, bool compress_runs) {
+        const size_t vertex_count = graph.GetVertexCount();
+        NextHopTable table;
+        table.vertex_count = vertex_count;
+
+        // позиция ребра в списке исходящих ребер его начала и наибольшая степень вершины
+        std::vector<uint32_t> edge_positions(graph.GetEdgeCount());
+        size_t max_degree = 0;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            const auto edge_ids = graph.GetIncidentEdges(vertex);
+            const size_t degree = edge_ids.end() - edge_ids.begin();
+            for (size_t i = 0; i < degree; ++i) {
+                edge_positions[edge_ids.begin()[i]] = static_cast<uint32_t>(i);
+            }
+            max_degree = std::max(max_degree, degree);
+        }
+        // позиции ребер - [0, max_degree), признак отсутствия маршрута не должен с ними совпадать
+        while (table.hop_width < 4 && max_degree > table.GetNoHop()) {
+            table.hop_width *= 2;
+        }
+        if (max_degree > table.GetNoHop()) {
+            throw std::length_error("Vertex degree doesn't fit into the next hop table");
+        }
+        const uint32_t no_hop = table.GetNoHop();
+        const auto write_hop = [&table](size_t index, uint32_t hop) {
+            uint8_t *cell = table.hops.data() + index * table.hop_width;
+            if (table.hop_width == 1) {
+                *cell = static_cast<uint8_t>(hop);
+            } else if (table.hop_width == 2) {
+                const auto narrow = static_cast<uint16_t>(hop);
+                std::memcpy(cell, &narrow, sizeof(narrow));
+            } else {
+                std::memcpy(cell, &hop, sizeof(hop));
+            }
+        };
+
+        // входящие ребра вершин подряд: ребра вершины to - [in_offsets[to], in_offsets[to + 1])
+        std::vector<size_t> in_offsets(vertex_count + 1, 0);
+        for (const auto &edge: graph.GetEdges()) {
+            ++in_offsets[edge.to + 1];
+        }
+        std::partial_sum(in_offsets.begin(), in_offsets.end(), in_offsets.begin());
+        std::vector<EdgeId> in_edges(graph.GetEdgeCount());
+        {
+            std::vector<size_t> next_positions(in_offsets.begin(), in_offsets.end() - 1);
+            for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+                in_edges[next_positions[graph.GetEdge(edge_id).to]++] = edge_id;
+            }
+        }
+
+        // столбцы считаются независимо, шаги - в полной матрице, которая затем пишется в таблицу
+        std::vector<uint32_t> hops(vertex_count * vertex_count, no_hop);
+        const auto compute_column = [&](size_t to) {
+            SearchData<Weight> &data = GetThreadSearchData<Weight>(SearchSlot::Backward);
+            data.Prepare(vertex_count);
+            data.Reach(to, Weight{}, SearchData<Weight>::NO_EDGE);
+            while (!data.heap.empty()) {
+                const auto [weight, vertex] = data.Pop();
+                if (data.weights[vertex] < weight) {
+                    continue;
+                }
+                for (size_t i = in_offsets[vertex]; i < in_offsets[vertex + 1]; ++i) {
+                    const auto &edge = graph.GetEdge(in_edges[i]);
+                    const Weight candidate_weight = weight + edge.weight;
+                    if (!data.IsReached(edge.from) || candidate_weight < data.weights[edge.from]) {
+                        data.Reach(edge.from, candidate_weight, in_edges[i]);
+                    }
+                }
+            }
+            for (VertexId from = 0; from < vertex_count; ++from) {
+                if (from != to && data.IsReached(from)) {
+                    hops[from * vertex_count + to] = edge_positions[data.prev_edges[from]];
+                }
+            }
+        };
+        parallel::ThreadPool thread_pool;
+        thread_pool.ParallelFor(vertex_count, compute_column);
+
+        if (!compress_runs) {
+            table.hops.resize(vertex_count * vertex_count * table.hop_width);
+        } else {
+            table.row_offsets.reserve(vertex_count + 1);
+            table.row_offsets.push_back(0);
+        }
+        for (VertexId from = 0; from < vertex_count; ++from) {
+            uint32_t *row = hops.data() + from * vertex_count;
+            // ячейка from -> from не читается; ей дается значение соседней, чтобы не разрывать серию
+            row[from] = from > 0 ? row[from - 1] : (vertex_count > 1 ? row[1] : no_hop);
+
+            if (!compress_runs) {
+                for (VertexId to = 0; to < vertex_count; ++to) {
+                    write_hop(from * vertex_count + to, row[to]);
+                }
+                continue;
+            }
+            for (VertexId to = 0; to < vertex_count; ++to) {
+                if (to == 0 || row[to] != row[to - 1]) {
+                    table.run_starts.push_back(static_cast<uint32_t>(to));
+                    table.hops.resize(table.hops.size() + table.hop_width);
+                    write_hop(table.run_starts.size() - 1, row[to]);
+                }
+            }
+            table.row_offsets.push_back(static_cast<uint32_t>(table.run_starts.size()));
+        }
+        return table;
+    }
+
+    template<typename Weight>
+    NextHopRouter<Weight>::NextHopRouter(const Graph &graph, NextHopTable &&table)
+            : graph_(graph), table_(std::move(table)), no_hop_(table_.GetNoHop()) {
+        const size_t vertex_count = graph.GetVertexCount();
+        const bool is_valid = table_.vertex_count == vertex_count
+                              && (table_.hop_width == 1 || table_.hop_width == 2 || table_.hop_width == 4)
+                              && (table_.HasRuns()
+                                  ? table_.row_offsets.size() == vertex_count + 1
+                                    && table_.row_offsets.back() == table_.run_starts.size()
+                                    && table_.hops.size() == table_.run_starts.size() * table_.hop_width
+                                  : table_.hops.size() == vertex_count * vertex_count * table_.hop_width);
+        if (!is_valid) {
+            throw std::invalid_argument("Next hop table doesn't match the graph");
+        }
+    }
+
+    template<typename Weight>
+    const NextHopTable &NextHopRouter<Weight>::GetTable() const {
+        return table_;
+    }
+
+    template<typename Weight>
+    std::optional<Weight> NextHopRouter<Weight>::BuildRoutePath(VertexId from, VertexId to,
+                                                                std::vector<EdgeId> &edges) const {
+        const size_t vertex_count = table_.vertex_count;
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        edges.clear();
+        for (VertexId vertex = from; vertex != to;) {
+            const uint32_t hop = GetHop(vertex, to);
+            if (hop == no_hop_) {
+                return std::nullopt;
+            }
+            // шаги построенной таблицы не зацикливаются; проверка - от испорченной таблицы из базы
+            if (edges.size() >= vertex_count) {
+                throw std::logic_error("Next hop table has a cycle");
+            }
+            const EdgeId edge_id = graph_.GetIncidentEdges(vertex).begin()[hop];
+            edges.push_back(edge_id);
+            vertex = graph_.GetEdge(edge_id).to;
+        }
+        // вес складывается от последнего ребра к первому, как в маршрутизаторе по таблице последних ребер
+        Weight weight = ZERO_WEIGHT;
+        for (auto it = edges.rbegin(); it != edges.rend(); ++it) {
+            weight += graph_.GetEdge(*it).weight;
+        }
+        return weight;
+    }
+
+}  // namespace graph
@@ -0,0 +1,170 @@
+#include "raptor.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace raptor {
+//----------------------------------------------------------------------------
+    Raptor::Raptor(const TransportCatalogue::TransportCatalogue &db, double velocity, size_t max_rides)
+            : stop_count_(db.GetStops().size()), max_rides_(max_rides) {
+        std::vector<size_t> stop_route_counts(stop_count_ + 1, 0);
+        const auto &buses = db.GetBuses();
+        for (size_t bus_id = 0; bus_id < buses.size(); ++bus_id) {
+            const domain::Bus &bus = buses[bus_id];
+            if (bus.departures.empty() || bus.stops.size() < 2) {
+                continue;
+            }
+            Route route{bus_id, route_stops_.size(), bus.stops.size(), departures_.size(), bus.departures.size()};
+            double offset = 0;
+            for (size_t i = 0; i < bus.stops.size(); ++i) {
+                if (i > 0) {
+                    offset += db.GetRangeStops(bus.stops[i - 1], bus.stops[i]) / velocity;
+                }
+                route_stops_.push_back(bus.stops[i]->id);
+                stop_offsets_.push_back(offset);
+                ++stop_route_counts[bus.stops[i]->id + 1];
+            }
+            departures_.insert(departures_.end(), bus.departures.begin(), bus.departures.end());
+            std::sort(departures_.begin() + route.departures_begin, departures_.end());
+            routes_.push_back(route);
+        }
+
+        // индекс маршрутов по остановкам
+        for (size_t stop = 0; stop < stop_count_; ++stop) {
+            stop_route_counts[stop + 1] += stop_route_counts[stop];
+        }
+        stop_routes_offsets_ = stop_route_counts;
+        stop_routes_.resize(route_stops_.size());
+        for (size_t route_id = 0; route_id < routes_.size(); ++route_id) {
+            const Route &route = routes_[route_id];
+            for (size_t position = 0; position < route.stop_count; ++position) {
+                stop_routes_[stop_route_counts[route_stops_[route.stops_begin + position]]++] = {route_id, position};
+            }
+        }
+    }
+
+//----------------------------------------------------------------------------
+    bool Raptor::IsEmpty() const {
+        return routes_.empty();
+    }
+
+//----------------------------------------------------------------------------
+    size_t Raptor::FindTrip(const Route &route, size_t position, double time) const {
+        const auto begin = departures_.begin() + route.departures_begin;
+        const auto end = begin + route.departure_count;
+        const auto it = std::lower_bound(begin, end, time - stop_offsets_[route.stops_begin + position]);
+        return it == end ? NO_TRIP : it - begin;
+    }
+
+//----------------------------------------------------------------------------
+    double Raptor::GetTripTime(const Route &route, size_t trip, size_t position) const {
+        return departures_[route.departures_begin + trip] + stop_offsets_[route.stops_begin + position];
+    }
+
+//----------------------------------------------------------------------------
+    std::optional<Journey> Raptor::BuildJourney(size_t stop_from, size_t stop_to, double departure_time) const {
+        constexpr double infinity = std::numeric_limits<double>::infinity();
+        if (stop_from >= stop_count_ || stop_to >= stop_count_) {
+            return std::nullopt;
+        }
+        if (stop_from == stop_to) {
+            return Journey{departure_time, departure_time, {}};
+        }
+
+        // arrivals[k * stop_count_ + s] - самое раннее прибытие на s не более чем с k поездками
+        std::vector<double> arrivals(stop_count_, infinity);
+        std::vector<Label> labels(stop_count_);
+        std::vector<double> best_arrivals(stop_count_, infinity);
+        arrivals[stop_from] = departure_time;
+        best_arrivals[stop_from] = departure_time;
+
+        std::vector<char> marked(stop_count_, 0);
+        std::vector<size_t> marked_stops{stop_from};
+        marked[stop_from] = 1;
+        // для каждого маршрута самая ранняя позиция отмеченной остановки
+        std::vector<size_t> route_positions(routes_.size(), NO_ROUTE);
+        std::vector<size_t> queued_routes;
+
+        size_t rounds = 0;
+        for (size_t round = 1; round <= max_rides_ && !marked_stops.empty(); ++round) {
+            for (const size_t stop: marked_stops) {
+                marked[stop] = 0;
+                for (size_t i = stop_routes_offsets_[stop]; i < stop_routes_offsets_[stop + 1]; ++i) {
+                    const auto [route_id, position] = stop_routes_[i];
+                    if (route_positions[route_id] == NO_ROUTE) {
+                        queued_routes.push_back(route_id);
+                        route_positions[route_id] = position;
+                    } else {
+                        route_positions[route_id] = std::min(route_positions[route_id], position);
+                    }
+                }
+            }
+            marked_stops.clear();
+
+            arrivals.resize((round + 1) * stop_count_, infinity);
+            labels.resize((round + 1) * stop_count_);
+            const double *prev_arrivals = &arrivals[(round - 1) * stop_count_];
+            double *round_arrivals = &arrivals[round * stop_count_];
+            Label *round_labels = &labels[round * stop_count_];
+
+            for (const size_t route_id: queued_routes) {
+                const Route &route = routes_[route_id];
+                size_t trip = NO_TRIP;
+                size_t board_position = 0;
+                for (size_t position = route_positions[route_id]; position < route.stop_count; ++position) {
+                    const size_t stop = route_stops_[route.stops_begin + position];
+                    if (trip != NO_TRIP) {
+                        // прибытие текущим рейсом; улучшение должно быть лучше и прибытия на цель
+                        const double arrival = GetTripTime(route, trip, position);
+                        if (arrival < std::min(best_arrivals[stop], best_arrivals[stop_to])) {
+                            round_arrivals[stop] = arrival;
+                            best_arrivals[stop] = arrival;
+                            round_labels[stop] = {route_id, trip, board_position, position};
+                            if (!marked[stop]) {
+                                marked[stop] = 1;
+                                marked_stops.push_back(stop);
+                            }
+                        }
+                    }
+                    // можно ли сесть здесь на более ранний рейс
+                    if (prev_arrivals[stop] < infinity
+                        && (trip == NO_TRIP || prev_arrivals[stop] <= GetTripTime(route, trip, position))) {
+                        const size_t earlier_trip = FindTrip(route, position, prev_arrivals[stop]);
+                        if (earlier_trip != NO_TRIP && (trip == NO_TRIP || earlier_trip < trip)) {
+                            trip = earlier_trip;
+                            board_position = position;
+                        }
+                    }
+                }
+                route_positions[route_id] = NO_ROUTE;
+            }
+            queued_routes.clear();
+            rounds = round;
+        }
+
+        if (best_arrivals[stop_to] == infinity) {
+            return std::nullopt;
+        }
+        // наименьшее число поездок, дающее самое раннее прибытие
+        size_t round = 1;
+        while (round <= rounds && arrivals[round * stop_count_ + stop_to] != best_arrivals[stop_to]) {
+            ++round;
+        }
+
+        Journey journey{departure_time, best_arrivals[stop_to], {}};
+        size_t stop = stop_to;
+        for (; round > 0; --round) {
+            const Label &label = labels[round * stop_count_ + stop];
+            const Route &route = routes_[label.route];
+            const size_t board_stop = route_stops_[route.stops_begin + label.board_position];
+            const double board_time = GetTripTime(route, label.trip, label.board_position);
+            journey.legs.push_back({board_stop, board_time - arrivals[(round - 1) * stop_count_ + board_stop],
+                                    route.bus_id, label.alight_position - label.board_position,
+                                    GetTripTime(route, label.trip, label.alight_position) - board_time});
+            stop = board_stop;
+        }
+        std::reverse(journey.legs.begin(), journey.legs.end());
+        return journey;
+    }
+//----------------------------------------------------------------------------
+}
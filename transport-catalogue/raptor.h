@@ -0,0 +1,81 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace raptor {
+
+    // поездка одним автобусом в найденном маршруте
+    struct Leg {
+        size_t board_stop_id = 0; // остановка посадки
+        double wait_time = 0; // ожидание рейса на остановке посадки, минуты
+        size_t bus_id = 0; // номер автобуса в справочнике
+        size_t span_count = 0; // кол-во пролетов между остановками посадки и высадки
+        double ride_time = 0; // минуты
+    };
+
+    struct Journey {
+        double departure_time = 0; // минуты от начала суток
+        double arrival_time = 0;
+        std::vector<Leg> legs;
+    };
+
+    // маршрутизация по расписанию (RAPTOR): поиск по раундам, в k-м раунде - маршруты не более чем с k поездками.
+    // Работает прямо по последовательностям остановок автобусов, у которых задано расписание, без графа;
+    // данные лежат в плоских массивах. Время в пути между остановками считается по дорожным расстояниям
+    // и скорости автобуса, поэтому рейсы одного автобуса не обгоняют друг друга
+    class Raptor {
+    public:
+        // velocity - скорость автобуса, м/мин
+        Raptor(const TransportCatalogue::TransportCatalogue &db, double velocity, size_t max_rides = 8);
+
+        // есть ли хотя бы один автобус с расписанием
+        bool IsEmpty() const;
+
+        // маршрут с самым ранним прибытием при отправлении не раньше departure_time;
+        // среди маршрутов с одинаковым прибытием выбирается маршрут с меньшим числом поездок
+        std::optional<Journey> BuildJourney(size_t stop_from, size_t stop_to, double departure_time) const;
+
+    private:
+        // автобус с расписанием
+        struct Route {
+            size_t bus_id = 0; // номер автобуса в справочнике
+            size_t stops_begin = 0; // позиции в route_stops_ и stop_offsets_
+            size_t stop_count = 0;
+            size_t departures_begin = 0; // рейсы в departures_
+            size_t departure_count = 0;
+        };
+
+        // откуда приехали на остановку в раунде
+        struct Label {
+            size_t route = NO_ROUTE;
+            size_t trip = 0;
+            size_t board_position = 0;
+            size_t alight_position = 0;
+        };
+
+        static constexpr size_t NO_ROUTE = static_cast<size_t>(-1);
+        static constexpr size_t NO_TRIP = static_cast<size_t>(-1);
+
+        // первый рейс маршрута, отправляющийся с позиции position не раньше time, NO_TRIP если такого нет
+        size_t FindTrip(const Route &route, size_t position, double time) const;
+
+        // время рейса trip маршрута на позиции position
+        double GetTripTime(const Route &route, size_t trip, size_t position) const;
+
+        size_t stop_count_ = 0;
+        size_t max_rides_ = 0;
+        std::vector<Route> routes_;
+        std::vector<size_t> route_stops_; // номера остановок автобусов подряд
+        std::vector<double> stop_offsets_; // время от первой остановки автобуса до каждой его остановки
+        std::vector<double> departures_; // время отправления рейсов с первой остановки, по возрастанию
+        // маршруты, проходящие через остановку s: [stop_routes_offsets_[s], stop_routes_offsets_[s + 1])
+        std::vector<size_t> stop_routes_offsets_;
+        std::vector<std::pair<size_t, size_t>> stop_routes_; // (маршрут, позиция остановки в нем)
+    };
+
+}  // namespace raptor
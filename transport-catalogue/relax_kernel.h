@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace graph {
+
+    // ядро релаксации плитки таблицы маршрутов Флойда-Уоршелла: для каждой промежуточной вершины through
+    // из [throughs) и строки from из [rows) улучшает ячейки from -> to, to из [columns), маршрутами через through.
+    // Таблица - плоские матрицы весов и последних ребер со строками длиной stride, no_route - вес отсутствующего
+    // маршрута; сумма с ним не должна становиться меньше других весов (бесконечность или половина диапазона)
+    template<typename TableWeight, typename TableEdgeId>
+    using RelaxTileKernel = void (*)(TableWeight *weights, TableEdgeId *prev_edges, size_t stride,
+                                     std::pair<size_t, size_t> rows, std::pair<size_t, size_t> columns,
+                                     std::pair<size_t, size_t> throughs, TableWeight no_route);
+
+    namespace relax_kernels {
+
+        template<typename TableWeight, typename TableEdgeId>
+        void RelaxTileScalar(TableWeight *weights, TableEdgeId *prev_edges, size_t stride,
+                             std::pair<size_t, size_t> rows, std::pair<size_t, size_t> columns,
+                             std::pair<size_t, size_t> throughs, TableWeight no_route) {
+            const size_t width = columns.second - columns.first;
+            for (size_t through = throughs.first; through < throughs.second; ++through) {
+                const TableWeight *weights_through = weights + through * stride + columns.first;
+                const TableEdgeId *prev_edges_through = prev_edges + through * stride + columns.first;
+                for (size_t from = rows.first; from < rows.second; ++from) {
+                    const TableWeight weight_from = weights[from * stride + through];
+                    if (weight_from == no_route) {
+                        continue;
+                    }
+                    TableWeight *weights_row = weights + from * stride + columns.first;
+                    TableEdgeId *prev_edges_row = prev_edges + from * stride + columns.first;
+                    for (size_t column = 0; column < width; ++column) {
+                        const TableWeight candidate_weight = weight_from + weights_through[column];
+                        if (candidate_weight < weights_row[column]) {
+                            weights_row[column] = candidate_weight;
+                            prev_edges_row[column] = prev_edges_through[column];
+                        }
+                    }
+                }
+            }
+        }
+
+#if defined(__GNUC__) && defined(__x86_64__)
+        // операции над 32-битными весами в векторных регистрах: ячейки хранятся как целые векторы,
+        // веса float переводятся в вещественные только для сложения и сравнения
+        template<typename TableWeight>
+        struct Sse2Weights;
+
+        template<>
+        struct Sse2Weights<float> {
+            static __m128i Broadcast(float weight) {
+                return _mm_castps_si128(_mm_set1_ps(weight));
+            }
+
+            static __m128i Add(__m128i lhs, __m128i rhs) {
+                return _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(lhs), _mm_castsi128_ps(rhs)));
+            }
+
+            static __m128i Less(__m128i lhs, __m128i rhs) {
+                return _mm_castps_si128(_mm_cmplt_ps(_mm_castsi128_ps(lhs), _mm_castsi128_ps(rhs)));
+            }
+        };
+
+        template<>
+        struct Sse2Weights<int32_t> {
+            static __m128i Broadcast(int32_t weight) {
+                return _mm_set1_epi32(weight);
+            }
+
+            static __m128i Add(__m128i lhs, __m128i rhs) {
+                return _mm_add_epi32(lhs, rhs);
+            }
+
+            static __m128i Less(__m128i lhs, __m128i rhs) {
+                return _mm_cmplt_epi32(lhs, rhs);
+            }
+        };
+
+        template<typename TableWeight>
+        struct Avx2Weights;
+
+        template<>
+        struct Avx2Weights<float> {
+            __attribute__((target("avx2"))) static __m256i Broadcast(float weight) {
+                return _mm256_castps_si256(_mm256_set1_ps(weight));
+            }
+
+            __attribute__((target("avx2"))) static __m256i Add(__m256i lhs, __m256i rhs) {
+                return _mm256_castps_si256(_mm256_add_ps(_mm256_castsi256_ps(lhs), _mm256_castsi256_ps(rhs)));
+            }
+
+            __attribute__((target("avx2"))) static __m256i Less(__m256i lhs, __m256i rhs) {
+                return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(lhs), _mm256_castsi256_ps(rhs),
+                                                         _CMP_LT_OQ));
+            }
+        };
+
+        template<>
+        struct Avx2Weights<int32_t> {
+            __attribute__((target("avx2"))) static __m256i Broadcast(int32_t weight) {
+                return _mm256_set1_epi32(weight);
+            }
+
+            __attribute__((target("avx2"))) static __m256i Add(__m256i lhs, __m256i rhs) {
+                return _mm256_add_epi32(lhs, rhs);
+            }
+
+            __attribute__((target("avx2"))) static __m256i Less(__m256i lhs, __m256i rhs) {
+                return _mm256_cmpgt_epi32(rhs, lhs);
+            }
+        };
+
+        // SSE2 есть у любого x86-64: по 4 ячейки, выбор по маске сравнения через and/andnot/or
+        template<typename TableWeight>
+        void RelaxTileSse2(TableWeight *weights, uint32_t *prev_edges, size_t stride,
+                           std::pair<size_t, size_t> rows, std::pair<size_t, size_t> columns,
+                           std::pair<size_t, size_t> throughs, TableWeight no_route) {
+            using Ops = Sse2Weights<TableWeight>;
+            const size_t width = columns.second - columns.first;
+            const size_t vector_width = width - width % 4;
+            for (size_t through = throughs.first; through < throughs.second; ++through) {
+                const TableWeight *weights_through = weights + through * stride + columns.first;
+                const uint32_t *prev_edges_through = prev_edges + through * stride + columns.first;
+                for (size_t from = rows.first; from < rows.second; ++from) {
+                    const TableWeight weight_from = weights[from * stride + through];
+                    if (weight_from == no_route) {
+                        continue;
+                    }
+                    TableWeight *weights_row = weights + from * stride + columns.first;
+                    uint32_t *prev_edges_row = prev_edges + from * stride + columns.first;
+                    const __m128i weight_from_vector = Ops::Broadcast(weight_from);
+                    size_t column = 0;
+                    for (; column < vector_width; column += 4) {
+                        const auto cells_through = reinterpret_cast<const __m128i *>(weights_through + column);
+                        const auto cells_row = reinterpret_cast<__m128i *>(weights_row + column);
+                        const __m128i candidate = Ops::Add(weight_from_vector, _mm_loadu_si128(cells_through));
+                        const __m128i current = _mm_loadu_si128(cells_row);
+                        const __m128i less = Ops::Less(candidate, current);
+                        if (_mm_movemask_epi8(less) == 0) {
+                            continue;
+                        }
+                        _mm_storeu_si128(cells_row, _mm_or_si128(_mm_and_si128(less, candidate),
+                                                                 _mm_andnot_si128(less, current)));
+                        const auto edges_through = reinterpret_cast<const __m128i *>(prev_edges_through + column);
+                        const auto edges_row = reinterpret_cast<__m128i *>(prev_edges_row + column);
+                        _mm_storeu_si128(edges_row, _mm_or_si128(_mm_and_si128(less, _mm_loadu_si128(edges_through)),
+                                                                 _mm_andnot_si128(less, _mm_loadu_si128(edges_row))));
+                    }
+                    for (; column < width; ++column) {
+                        const TableWeight candidate_weight = weight_from + weights_through[column];
+                        if (candidate_weight < weights_row[column]) {
+                            weights_row[column] = candidate_weight;
+                            prev_edges_row[column] = prev_edges_through[column];
+                        }
+                    }
+                }
+            }
+        }
+
+        // AVX2: по 8 ячеек, веса и последние ребра выбираются одной маской через blendv
+        template<typename TableWeight>
+        __attribute__((target("avx2")))
+        void RelaxTileAvx2(TableWeight *weights, uint32_t *prev_edges, size_t stride,
+                           std::pair<size_t, size_t> rows, std::pair<size_t, size_t> columns,
+                           std::pair<size_t, size_t> throughs, TableWeight no_route) {
+            using Ops = Avx2Weights<TableWeight>;
+            const size_t width = columns.second - columns.first;
+            const size_t vector_width = width - width % 8;
+            for (size_t through = throughs.first; through < throughs.second; ++through) {
+                const TableWeight *weights_through = weights + through * stride + columns.first;
+                const uint32_t *prev_edges_through = prev_edges + through * stride + columns.first;
+                for (size_t from = rows.first; from < rows.second; ++from) {
+                    const TableWeight weight_from = weights[from * stride + through];
+                    if (weight_from == no_route) {
+                        continue;
+                    }
+                    TableWeight *weights_row = weights + from * stride + columns.first;
+                    uint32_t *prev_edges_row = prev_edges + from * stride + columns.first;
+                    const __m256i weight_from_vector = Ops::Broadcast(weight_from);
+                    size_t column = 0;
+                    for (; column < vector_width; column += 8) {
+                        const auto cells_through = reinterpret_cast<const __m256i *>(weights_through + column);
+                        const auto cells_row = reinterpret_cast<__m256i *>(weights_row + column);
+                        const __m256i candidate = Ops::Add(weight_from_vector, _mm256_loadu_si256(cells_through));
+                        const __m256i current = _mm256_loadu_si256(cells_row);
+                        const __m256i less = Ops::Less(candidate, current);
+                        if (_mm256_testz_si256(less, less)) {
+                            continue;
+                        }
+                        _mm256_storeu_si256(cells_row, _mm256_blendv_epi8(current, candidate, less));
+                        const auto edges_through = reinterpret_cast<const __m256i *>(prev_edges_through + column);
+                        const auto edges_row = reinterpret_cast<__m256i *>(prev_edges_row + column);
+                        _mm256_storeu_si256(edges_row, _mm256_blendv_epi8(_mm256_loadu_si256(edges_row),
+                                                                          _mm256_loadu_si256(edges_through), less));
+                    }
+                    for (; column < width; ++column) {
+                        const TableWeight candidate_weight = weight_from + weights_through[column];
+                        if (candidate_weight < weights_row[column]) {
+                            weights_row[column] = candidate_weight;
+                            prev_edges_row[column] = prev_edges_through[column];
+                        }
+                    }
+                }
+            }
+        }
+
+        // векторное ядро по возможностям процессора, выбирается один раз для типа веса
+        template<typename TableWeight>
+        RelaxTileKernel<TableWeight, uint32_t> SelectVectorKernel() {
+            static const RelaxTileKernel<TableWeight, uint32_t> kernel = __builtin_cpu_supports("avx2")
+                                                                         ? &RelaxTileAvx2<TableWeight>
+                                                                         : &RelaxTileSse2<TableWeight>;
+            return kernel;
+        }
+#endif
+
+    }  // namespace relax_kernels
+
+    // ядро для типов таблицы; векторные варианты есть для 32-битных весов (float и целых фиксированной точки)
+    // с 32-битными номерами ребер, выбор между AVX2 и SSE2 делается один раз по возможностям процессора
+    template<typename TableWeight, typename TableEdgeId>
+    RelaxTileKernel<TableWeight, TableEdgeId> GetRelaxTileKernel() {
+        return &relax_kernels::RelaxTileScalar<TableWeight, TableEdgeId>;
+    }
+
+#if defined(__GNUC__) && defined(__x86_64__)
+    template<>
+    inline RelaxTileKernel<float, uint32_t> GetRelaxTileKernel<float, uint32_t>() {
+        return relax_kernels::SelectVectorKernel<float>();
+    }
+
+    template<>
+    inline RelaxTileKernel<int32_t, uint32_t> GetRelaxTileKernel<int32_t, uint32_t>() {
+        return relax_kernels::SelectVectorKernel<int32_t>();
+    }
+#endif
+
+}  // namespace graph
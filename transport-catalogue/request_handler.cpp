@@ -9,6 +9,44 @@ RequestHandler::RequestHandler(TransportCatalogue::TransportCatalogue &t_c,
 
 }
 
+//----------------------------------------------------------------------------
+bool RequestHandler::UpdateDistance(std::string_view stop_from, std::string_view stop_to, size_t distance) {
+    const auto opt_stop_from = t_c_.FindStop(stop_from);
+    const auto opt_stop_to = t_c_.FindStop(stop_to);
+    if (!opt_stop_from || !opt_stop_to) {
+        return false;
+    }
+    t_c_.AddRangeStops({std::string(stop_from), std::string(stop_to), distance});
+    if (!t_r_.GetGraphIsNoInit()) {
+        t_r_.UpdateDistance(t_c_, opt_stop_from.value(), opt_stop_to.value());
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------
+void RequestHandler::AddBus(const domain::Bus &bus) {
+    RemoveBus(bus.name);
+    t_c_.AddBus(bus);
+    if (!t_r_.GetGraphIsNoInit()) {
+        t_r_.AddBus(t_c_, t_c_.GetBuses().back());
+    }
+    UpdateMapRenderer();
+}
+
+//----------------------------------------------------------------------------
+bool RequestHandler::RemoveBus(std::string_view bus_name) {
+    // имя копируется: строка автобуса удаляется вместе с ним
+    const std::string name(bus_name);
+    if (!t_c_.RemoveBus(name)) {
+        return false;
+    }
+    if (!t_r_.GetGraphIsNoInit()) {
+        t_r_.RemoveBus(t_c_, name);
+    }
+    UpdateMapRenderer();
+    return true;
+}
+
 //----------------------------------------------------------------------------
 std::optional<domain::BusStat> RequestHandler::GetBusStat(const std::string_view &bus_name) const {
     if (auto opt_bus = t_c_.FindBus(bus_name); opt_bus) {
@@ -19,7 +57,7 @@ std::optional<domain::BusStat> RequestHandler::GetBusStat(const std::string_view
 }
 
 //----------------------------------------------------------------------------
-std::optional<domain::RoutStat>
+domain::RoutStatPtr
 RequestHandler::GetRouteStat(std::string_view stop_from, std::string_view stop_to) const {
     if (t_r_.GetGraphIsNoInit()) {
         std::cerr << "CreateGraph" << std::endl;
@@ -28,6 +66,94 @@ RequestHandler::GetRouteStat(std::string_view stop_from, std::string_view stop_t
     return t_r_.GetRouteStat(t_c_.FindStop(stop_from).value()->id, t_c_.FindStop(stop_to).value()->id);
 }
 
+//----------------------------------------------------------------------------
+std::vector<domain::RoutStatPtr>
+RequestHandler::GetRouteStats(std::string_view stop_from, const std::vector<std::string_view> &stops_to) const {
+    if (t_r_.GetGraphIsNoInit()) {
+        std::cerr << "CreateGraph" << std::endl;
+        t_r_.CreateGraph(t_c_);
+    }
+    std::vector<size_t> ids_to;
+    ids_to.reserve(stops_to.size());
+    for (const std::string_view stop_to: stops_to) {
+        ids_to.push_back(t_c_.FindStop(stop_to).value()->id);
+    }
+    return t_r_.GetRouteStats(t_c_.FindStop(stop_from).value()->id, ids_to);
+}
+
+//----------------------------------------------------------------------------
+domain::RoutStatPtr
+RequestHandler::GetTimetableRouteStat(std::string_view stop_from, std::string_view stop_to,
+                                      double departure_time) const {
+    const auto opt_stop_from = t_c_.FindStop(stop_from);
+    const auto opt_stop_to = t_c_.FindStop(stop_to);
+    if (!opt_stop_from || !opt_stop_to) {
+        return nullptr;
+    }
+    if (t_r_.GetGraphIsNoInit()) {
+        std::cerr << "CreateGraph" << std::endl;
+        t_r_.CreateGraph(t_c_);
+    }
+    return t_r_.GetTimetableRouteStat(opt_stop_from.value()->id, opt_stop_to.value()->id, departure_time);
+}
+
+//----------------------------------------------------------------------------
+std::optional<std::vector<domain::RoutStatPtr>>
+RequestHandler::GetAlternativeRouteStats(std::string_view stop_from, std::string_view stop_to, size_t count) const {
+    const auto opt_stop_from = t_c_.FindStop(stop_from);
+    const auto opt_stop_to = t_c_.FindStop(stop_to);
+    if (!opt_stop_from || !opt_stop_to) {
+        return std::nullopt;
+    }
+    if (t_r_.GetGraphIsNoInit()) {
+        std::cerr << "CreateGraph" << std::endl;
+        t_r_.CreateGraph(t_c_);
+    }
+    return t_r_.GetAlternativeRouteStats(opt_stop_from.value()->id, opt_stop_to.value()->id, count);
+}
+
+//----------------------------------------------------------------------------
+std::optional<domain::TimeMatrix>
+RequestHandler::GetTimeMatrix(const std::vector<std::string> &stops_from, const std::vector<std::string> &stops_to) const {
+    // номера остановок по именам, пустой результат если хотя бы одной остановки нет
+    const auto find_ids = [this](const std::vector<std::string> &stop_names) -> std::optional<std::vector<size_t>> {
+        std::vector<size_t> ids;
+        ids.reserve(stop_names.size());
+        for (const std::string &stop_name: stop_names) {
+            const auto opt_stop = t_c_.FindStop(stop_name);
+            if (!opt_stop) {
+                return std::nullopt;
+            }
+            ids.push_back(opt_stop.value()->id);
+        }
+        return ids;
+    };
+    const auto ids_from = find_ids(stops_from);
+    const auto ids_to = find_ids(stops_to);
+    if (!ids_from || !ids_to) {
+        return std::nullopt;
+    }
+    if (t_r_.GetGraphIsNoInit()) {
+        std::cerr << "CreateGraph" << std::endl;
+        t_r_.CreateGraph(t_c_);
+    }
+    return t_r_.GetTimeMatrix(*ids_from, *ids_to);
+}
+
+//----------------------------------------------------------------------------
+std::optional<std::vector<domain::ReachableStop>>
+RequestHandler::GetReachableStops(std::string_view stop_from, double max_time) const {
+    const auto opt_stop = t_c_.FindStop(stop_from);
+    if (!opt_stop) {
+        return std::nullopt;
+    }
+    if (t_r_.GetGraphIsNoInit()) {
+        std::cerr << "CreateGraph" << std::endl;
+        t_r_.CreateGraph(t_c_);
+    }
+    return t_r_.GetReachableStops(opt_stop.value(), max_time);
+}
+
 //----------------------------------------------------------------------------
 std::optional<const std::unordered_set<const domain::Bus *> *>
 RequestHandler::GetBusesByStop(const std::string_view &stop_name) const {
@@ -68,17 +194,28 @@ svg::Document RequestHandler::RenderMap() const {
 }
 
 //----------------------------------------------------------------------------
-void RequestHandler::CallDsrlz(const std::filesystem::path &path) {
+void RequestHandler::CallDsrlz(const std::filesystem::path &path, const std::filesystem::path &router_table_path) {
     Serialization d_srlz;
     d_srlz.Deserialize(path, t_c_, m_r_, t_r_);
-    m_r_.SetBuses(GetBusesLex());
-    m_r_.SetUnicStops(GetUnicLexStopsIncludeBuses());
+    if (!router_table_path.empty()) {
+        d_srlz.MapRouterTable(router_table_path, t_r_);
+    }
+    UpdateMapRenderer();
 }
 
 //----------------------------------------------------------------------------
-void RequestHandler::CallSrlz(const std::filesystem::path &path) const {
+void RequestHandler::CallSrlz(const std::filesystem::path &path, const std::filesystem::path &router_table_path) const {
     Serialization srlz;
     srlz.Serialize(t_c_, m_r_, t_r_, path);
+    if (!router_table_path.empty()) {
+        srlz.SerializeRouterTable(t_r_, router_table_path);
+    }
+}
+
+//----------------------------------------------------------------------------
+void RequestHandler::UpdateMapRenderer() {
+    m_r_.SetBuses(GetBusesLex());
+    m_r_.SetUnicStops(GetUnicLexStopsIncludeBuses());
 }
 
 //----------------------------------------------------------------------------
@@ -15,11 +15,43 @@ public:
                    TransportRouter::TransportRouter &t_r,
                    renderer::MapRenderer &m_r);
 
+    // изменения базы: справочник меняется, граф и маршрутизатор обновляются без полного перестроения
+
+    // false если какой-то остановки нет
+    bool UpdateDistance(std::string_view stop_from, std::string_view stop_to, size_t distance);
+
+    // автобус с тем же именем заменяется
+    void AddBus(const domain::Bus &bus);
+
+    // false если автобуса нет
+    bool RemoveBus(std::string_view bus_name);
+
     // Возвращает информацию о маршруте (запрос Bus)
     std::optional<domain::BusStat> GetBusStat(const std::string_view &bus_name) const;
 
     // Возвращает информацию о маршруте (запрос Route)
-    std::optional<domain::RoutStat> GetRouteStat(std::string_view stop_from, std::string_view stop_to) const;
+    domain::RoutStatPtr GetRouteStat(std::string_view stop_from, std::string_view stop_to) const;
+
+    // маршруты из одной остановки в несколько, в порядке stops_to
+    std::vector<domain::RoutStatPtr> GetRouteStats(std::string_view stop_from,
+                                                   const std::vector<std::string_view> &stops_to) const;
+
+    // маршрут по расписанию с отправлением не раньше departure_time (минуты от начала суток)
+    domain::RoutStatPtr GetTimetableRouteStat(std::string_view stop_from, std::string_view stop_to,
+                                              double departure_time) const;
+
+    // до count маршрутов между остановками по возрастанию времени, nullopt если какой-то остановки нет
+    std::optional<std::vector<domain::RoutStatPtr>> GetAlternativeRouteStats(std::string_view stop_from,
+                                                                             std::string_view stop_to,
+                                                                             size_t count) const;
+
+    // матрица времени в пути между остановками stops_from и stops_to, nullopt если какой-то остановки нет
+    std::optional<domain::TimeMatrix> GetTimeMatrix(const std::vector<std::string> &stops_from,
+                                                    const std::vector<std::string> &stops_to) const;
+
+    // остановки, до которых можно доехать от stop_from не дольше max_time минут, nullopt если остановки нет
+    std::optional<std::vector<domain::ReachableStop>> GetReachableStops(std::string_view stop_from,
+                                                                        double max_time) const;
 
     // Возвращает маршруты, проходящие через
     std::optional<const std::unordered_set<const domain::Bus *> *>
@@ -32,11 +64,15 @@ public:
 
     svg::Document RenderMap() const;
 
-    void CallDsrlz(const std::filesystem::path &path);
+    // router_table_path - необязательный файл таблицы маршрутизатора, отображаемый в память
+    void CallDsrlz(const std::filesystem::path &path, const std::filesystem::path &router_table_path = {});
 
-    void CallSrlz(const std::filesystem::path &path) const;
+    void CallSrlz(const std::filesystem::path &path, const std::filesystem::path &router_table_path = {}) const;
 
 private:
+    // визуализатор хранит указатели на автобусы и остановки справочника, после изменений они задаются заново
+    void UpdateMapRenderer();
+
     domain::BusStat CreateBusStat(const domain::Bus *bus) const;
 
     TransportCatalogue::TransportCatalogue &t_c_;
@@ -1,11 +1,16 @@
 #pragma once
 
 #include "graph.h"
+#include "relax_kernel.h"
+#include "search_data.h"
+#include "thread_pool.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
+#include <memory>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -14,102 +19,399 @@
 
 namespace graph {
 
+    // общий интерфейс маршрутизаторов, отвечающих на запрос маршрута между двумя вершинами
     template<typename Weight>
-    class Router {
+    class RouterBase {
+    public:
+        struct RouteInfo {
+            Weight weight;
+            std::vector<EdgeId> edges;
+        };
+
+        virtual ~RouterBase() = default;
+
+        // вес кратчайшего маршрута; его ребра записываются в edges вызывающего в порядке следования,
+        // так повторные запросы с одним буфером не выделяют память
+        virtual std::optional<Weight> BuildRoutePath(VertexId from, VertexId to, std::vector<EdgeId> &edges) const = 0;
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const {
+            std::vector<EdgeId> edges;
+            const std::optional<Weight> weight = BuildRoutePath(from, to, edges);
+            if (!weight) {
+                return std::nullopt;
+            }
+            return RouteInfo{*weight, std::move(edges)};
+        }
+
+        // выгоднее ли BuildRoutes для нескольких целей, чем отдельные запросы
+        virtual bool HasBatchSearch() const {
+            return false;
+        }
+
+        // маршруты из одной вершины в каждую из вершин to, в том же порядке;
+        // по умолчанию - отдельный запрос на каждую пару
+        virtual std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from,
+                                                                  const std::vector<VertexId> &to) const {
+            std::vector<std::optional<RouteInfo>> routes;
+            routes.reserve(to.size());
+            for (const VertexId vertex: to) {
+                routes.push_back(BuildRoute(from, vertex));
+            }
+            return routes;
+        }
+    };
+
+    // маршрутизатор с предрасчетом кратчайших путей между всеми парами вершин (Флойд-Уоршелл);
+    // таблица маршрутов хранится плоскими матрицами весов и последних ребер пути,
+    // ширина которых задается параметрами TableWeight и TableEdgeId
+    template<typename Weight, typename TableWeight = Weight, typename TableEdgeId = EdgeId>
+    class Router : public RouterBase<Weight> {
     private:
         using Graph = DirectedWeightedGraph<Weight>;
 
     public:
+        using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+        using TableWeightType = TableWeight;
+        using TableEdgeIdType = TableEdgeId;
+
+        // признак отсутствия последнего ребра в таблице: маршрута нет или это маршрут из вершины в саму себя
+        static constexpr TableEdgeId NO_EDGE = std::numeric_limits<TableEdgeId>::max();
+
         explicit Router(const Graph &graph);
 
-        struct RouteInfo {
-            Weight weight;
-            std::vector<EdgeId> edges;
-        };
+        // восстанавливает маршрутизатор по ранее рассчитанной таблице маршрутов без повторного расчета
+        Router(const Graph &graph, std::vector<TableWeight> &&weights, std::vector<TableEdgeId> &&prev_edges);
 
-        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        // работает с таблицей во внешней памяти (например, отображенном файле) без копирования,
+        // table_holder владеет этой памятью на время жизни маршрутизатора
+        Router(const Graph &graph, const TableWeight *weights, const TableEdgeId *prev_edges,
+               std::shared_ptr<const void> table_holder);
+
+        std::optional<Weight> BuildRoutePath(VertexId from, VertexId to, std::vector<EdgeId> &edges) const override;
+
+        // количество ячеек таблицы маршрутов
+        size_t GetTableSize() const;
+
+        const TableWeight *GetTableWeights() const;
+
+        const TableEdgeId *GetTablePrevEdges() const;
+
+        // Обновление таблицы после изменения графа, на который ссылается маршрутизатор, без полного пересчета.
+        // Таблица во внешней памяти при первом изменении копируется в собственную.
+
+        // начальные вершины, в кратчайших маршрутах из которых участвует хотя бы одно из ребер edge_ids
+        std::vector<VertexId> GetRowsUsingEdges(const std::vector<EdgeId> &edge_ids) const;
+
+        // пересчитывает строки таблицы поиском Дейкстры по текущему графу
+        void RecomputeRows(const std::vector<VertexId> &rows);
+
+        // улучшает маршруты через ребра, которые добавлены в граф или веса которых уменьшились, по одному ребру
+        // за проход по строкам; остальная таблица должна быть точной для графа без этих изменений
+        void RelaxThroughEdges(const std::vector<EdgeId> &edge_ids);
+
+        // сдвигает номера ребер после удаления из графа ребер [first, last); строки, маршруты которых
+        // проходили через удаленные ребра (GetRowsUsingEdges до удаления), нужно затем пересчитать
+        void RemoveEdgeRange(EdgeId first, EdgeId last);
 
     private:
-        struct RouteInternalData {
-            Weight weight;
-            std::optional<EdgeId> prev_edge;
-        };
-        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+        using VertexRange = std::pair<VertexId, VertexId>;  // полуинтервал вершин [first, second)
+
+        // вес отсутствующего маршрута; для целых - половина диапазона, чтобы сумма двух весов не переполнялась
+        static constexpr TableWeight NO_ROUTE = std::numeric_limits<TableWeight>::has_infinity
+                                                ? std::numeric_limits<TableWeight>::infinity()
+                                                : std::numeric_limits<TableWeight>::max() / 2;
+        size_t GetIndex(VertexId from, VertexId to) const {
+            return from * vertex_count_ + to;
+        }
 
         void InitializeRoutesInternalData(const Graph &graph) {
-            const size_t vertex_count = graph.GetVertexCount();
-            for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-                routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+            if (graph.GetEdgeCount() >= NO_EDGE) {
+                throw std::length_error("Edges' count doesn't fit into the route table edge id type");
+            }
+            for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+                weights_[GetIndex(vertex, vertex)] = TableWeight{};
                 for (const EdgeId edge_id: graph.GetIncidentEdges(vertex)) {
                     const auto &edge = graph.GetEdge(edge_id);
                     if (edge.weight < ZERO_WEIGHT) {
                         throw std::domain_error("Edges' weights should be non-negative");
                     }
-                    auto &route_internal_data = routes_internal_data_[vertex][edge.to];
-                    if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                        route_internal_data = RouteInternalData{edge.weight, edge_id};
+                    const auto edge_weight = static_cast<TableWeight>(edge.weight);
+                    const size_t index = GetIndex(vertex, edge.to);
+                    if (weights_[index] > edge_weight) {
+                        weights_[index] = edge_weight;
+                        prev_edges_[index] = static_cast<TableEdgeId>(edge_id);
                     }
                 }
             }
         }
 
-        void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData &route_from,
-                        const RouteInternalData &route_to) {
-            auto &route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-            const Weight candidate_weight = route_from.weight + route_to.weight;
-            if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-                route_relaxing = {candidate_weight,
-                                  route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
-            }
+        // релаксирует маршруты плитки [rows) x [columns) через вершины плитки [throughs);
+        // последним ребром улучшенного маршрута from -> to становится последнее ребро маршрута through -> to
+        void RelaxTile(VertexRange rows, VertexRange columns, VertexRange throughs) {
+            relax_tile_(weights_.data(), prev_edges_.data(), vertex_count_, rows, columns, throughs, NO_ROUTE);
         }
 
-        void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-            for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-                if (const auto &route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                    for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                        if (const auto &route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+        // Флойд-Уоршелл по плиткам: для каждого блока промежуточных вершин сначала диагональная плитка,
+        // затем плитки его строки и столбца, затем все остальные; плитки одной фазы независимы
+        void RelaxRoutesInternalDataBlocked() {
+            const size_t vertex_count = vertex_count_;
+            const size_t block_count = (vertex_count + TILE_SIZE - 1) / TILE_SIZE;
+            const auto block = [vertex_count](size_t index) {
+                return VertexRange{index * TILE_SIZE, std::min(vertex_count, (index + 1) * TILE_SIZE)};
+            };
+            parallel::ThreadPool thread_pool;
+            for (size_t block_through = 0; block_through < block_count; ++block_through) {
+                const VertexRange throughs = block(block_through);
+                RelaxTile(throughs, throughs, throughs);
+                // плитки строки и столбца блока, первая половина индексов - строка, вторая - столбец
+                thread_pool.ParallelFor(2 * block_count, [&](size_t index) {
+                    const size_t other = index % block_count;
+                    if (other == block_through) {
+                        return;
+                    }
+                    if (index < block_count) {
+                        RelaxTile(throughs, block(other), throughs);
+                    } else {
+                        RelaxTile(block(other), throughs, throughs);
+                    }
+                });
+                // остальные плитки, задача - строка плиток
+                thread_pool.ParallelFor(block_count, [&](size_t block_from) {
+                    if (block_from == block_through) {
+                        return;
+                    }
+                    for (size_t block_to = 0; block_to < block_count; ++block_to) {
+                        if (block_to != block_through) {
+                            RelaxTile(block(block_from), block(block_to), throughs);
                         }
                     }
-                }
+                });
+            }
+        }
+
+        // один проход по строкам для ребра edge_id
+        void RelaxThroughEdge(parallel::ThreadPool &thread_pool, EdgeId edge_id);
+
+        // пул потоков обновлений таблицы: создается при первом обновлении и служит всем следующим
+        parallel::ThreadPool &GetUpdateThreadPool() {
+            if (!update_thread_pool_) {
+                update_thread_pool_ = std::make_unique<parallel::ThreadPool>();
             }
+            return *update_thread_pool_;
         }
 
+        // переносит таблицу из внешней памяти в собственные векторы, чтобы ее можно было менять
+        void MakeTableOwned() {
+            if (table_weights_ == weights_.data() && !weights_.empty()) {
+                return;
+            }
+            const size_t table_size = GetTableSize();
+            weights_.assign(table_weights_, table_weights_ + table_size);
+            prev_edges_.assign(table_prev_edges_, table_prev_edges_ + table_size);
+            table_weights_ = weights_.data();
+            table_prev_edges_ = prev_edges_.data();
+            table_holder_.reset();
+        }
+
+        static constexpr size_t TILE_SIZE = 64;  // сторона плитки таблицы маршрутов
+        // векторное ядро релаксации плитки, если оно есть для типов таблицы и процессора
+        const RelaxTileKernel<TableWeight, TableEdgeId> relax_tile_ = GetRelaxTileKernel<TableWeight, TableEdgeId>();
         static constexpr Weight ZERO_WEIGHT{};
         const Graph &graph_;
-        RoutesInternalData routes_internal_data_;
+        size_t vertex_count_;
+        std::vector<TableWeight> weights_;  // веса маршрутов, строка - начальная вершина
+        std::vector<TableEdgeId> prev_edges_;  // последние ребра маршрутов
+        // таблица, по которой отвечают запросы: данные векторов выше либо внешняя память
+        const TableWeight *table_weights_ = nullptr;
+        const TableEdgeId *table_prev_edges_ = nullptr;
+        std::shared_ptr<const void> table_holder_;
+        std::unique_ptr<parallel::ThreadPool> update_thread_pool_;
     };
 
-    template<typename Weight>
-    Router<Weight>::Router(const Graph &graph)
-            : graph_(graph), routes_internal_data_(graph.GetVertexCount(),
-                                                   std::vector<std::optional<RouteInternalData>>(
-                                                           graph.GetVertexCount())) {
+    template<typename Weight, typename TableWeight, typename TableEdgeId>
+    Router<Weight, TableWeight, TableEdgeId>::Router(const Graph &graph)
+            : graph_(graph), vertex_count_(graph.GetVertexCount()),
+              weights_(vertex_count_ * vertex_count_, NO_ROUTE),
+              prev_edges_(vertex_count_ * vertex_count_, NO_EDGE) {
         InitializeRoutesInternalData(graph);
+        RelaxRoutesInternalDataBlocked();
+        table_weights_ = weights_.data();
+        table_prev_edges_ = prev_edges_.data();
+    }
 
-        const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    template<typename Weight, typename TableWeight, typename TableEdgeId>
+    Router<Weight, TableWeight, TableEdgeId>::Router(const Graph &graph, std::vector<TableWeight> &&weights,
+                                                     std::vector<TableEdgeId> &&prev_edges)
+            : graph_(graph), vertex_count_(graph.GetVertexCount()),
+              weights_(std::move(weights)), prev_edges_(std::move(prev_edges)) {
+        if (weights_.size() != vertex_count_ * vertex_count_ || prev_edges_.size() != weights_.size()) {
+            throw std::invalid_argument("Route table size doesn't match the graph");
         }
+        table_weights_ = weights_.data();
+        table_prev_edges_ = prev_edges_.data();
     }
 
-    template<typename Weight>
-    std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                                 VertexId to) const {
-        const auto &route_internal_data = routes_internal_data_.at(from).at(to);
-        if (!route_internal_data) {
+    template<typename Weight, typename TableWeight, typename TableEdgeId>
+    Router<Weight, TableWeight, TableEdgeId>::Router(const Graph &graph, const TableWeight *weights,
+                                                     const TableEdgeId *prev_edges,
+                                                     std::shared_ptr<const void> table_holder)
+            : graph_(graph), vertex_count_(graph.GetVertexCount()),
+              table_weights_(weights), table_prev_edges_(prev_edges), table_holder_(std::move(table_holder)) {
+    }
+
+    template<typename Weight, typename TableWeight, typename TableEdgeId>
+    size_t Router<Weight, TableWeight, TableEdgeId>::GetTableSize() const {
+        return vertex_count_ * vertex_count_;
+    }
+
+    template<typename Weight, typename TableWeight, typename TableEdgeId>
+    const TableWeight *Router<Weight, TableWeight, TableEdgeId>::GetTableWeights() const {
+        return table_weights_;
+    }
+
+    template<typename Weight, typename TableWeight, typename TableEdgeId>
+    const TableEdgeId *Router<Weight, TableWeight, TableEdgeId>::GetTablePrevEdges() const {
+        return table_prev_edges_;
+    }
+
+    template<typename Weight, typename TableWeight, typename TableEdgeId>
+    std::vector<VertexId>
+    Router<Weight, TableWeight, TableEdgeId>::GetRowsUsingEdges(const std::vector<EdgeId> &edge_ids) const {
+        // ребро входит в дерево кратчайших маршрутов строки, только если оно последнее в маршруте до своего конца
+        std::vector<VertexId> rows;
+        for (VertexId from = 0; from < vertex_count_; ++from) {
+            for (const EdgeId edge_id: edge_ids) {
+                const TableEdgeId prev_edge = table_prev_edges_[GetIndex(from, graph_.GetEdge(edge_id).to)];
+                if (prev_edge != NO_EDGE && prev_edge == edge_id) {
+                    rows.push_back(from);
+                    break;
+                }
+            }
+        }
+        return rows;
+    }
+
+    template<typename Weight, typename TableWeight, typename TableEdgeId>
+    void Router<Weight, TableWeight, TableEdgeId>::RecomputeRows(const std::vector<VertexId> &rows) {
+        if (rows.empty()) {
+            return;
+        }
+        if (graph_.GetEdgeCount() >= NO_EDGE) {
+            throw std::length_error("Edges' count doesn't fit into the route table edge id type");
+        }
+        MakeTableOwned();
+        const auto recompute_row = [this, &rows](size_t index) {
+            const VertexId from = rows[index];
+            SearchData<Weight> &data = GetThreadSearchData<Weight>();
+            data.Prepare(vertex_count_);
+            data.Reach(from, ZERO_WEIGHT, SearchData<Weight>::NO_EDGE);
+            while (!data.heap.empty()) {
+                const auto [weight, vertex] = data.Pop();
+                if (data.weights[vertex] < weight) {
+                    continue;
+                }
+                const auto edge_ids = graph_.GetIncidentEdges(vertex);
+                const VertexId *targets = graph_.GetIncidentTargets(vertex).begin();
+                const Weight *edge_weights = graph_.GetIncidentWeights(vertex).begin();
+                for (size_t i = 0, count = edge_ids.end() - edge_ids.begin(); i < count; ++i) {
+                    const Weight candidate_weight = weight + edge_weights[i];
+                    if (!data.IsReached(targets[i]) || candidate_weight < data.weights[targets[i]]) {
+                        data.Reach(targets[i], candidate_weight, edge_ids.begin()[i]);
+                    }
+                }
+            }
+            for (VertexId to = 0; to < vertex_count_; ++to) {
+                const size_t table_index = GetIndex(from, to);
+                if (!data.IsReached(to)) {
+                    weights_[table_index] = NO_ROUTE;
+                    prev_edges_[table_index] = NO_EDGE;
+                } else {
+                    weights_[table_index] = static_cast<TableWeight>(data.weights[to]);
+                    prev_edges_[table_index] = to == from ? NO_EDGE : static_cast<TableEdgeId>(data.prev_edges[to]);
+                }
+            }
+        };
+        GetUpdateThreadPool().ParallelFor(rows.size(), recompute_row);
+    }
+
+    template<typename Weight, typename TableWeight, typename TableEdgeId>
+    void Router<Weight, TableWeight, TableEdgeId>::RelaxThroughEdges(const std::vector<EdgeId> &edge_ids) {
+        if (edge_ids.empty()) {
+            return;
+        }
+        if (*std::max_element(edge_ids.begin(), edge_ids.end()) >= NO_EDGE) {
+            throw std::length_error("Edges' count doesn't fit into the route table edge id type");
+        }
+        MakeTableOwned();
+        parallel::ThreadPool &thread_pool = GetUpdateThreadPool();
+        // ребра по очереди: проход по строкам для ребра читает строку его конца, уже улучшенную предыдущими
+        for (const EdgeId edge_id: edge_ids) {
+            RelaxThroughEdge(thread_pool, edge_id);
+        }
+    }
+
+    template<typename Weight, typename TableWeight, typename TableEdgeId>
+    void Router<Weight, TableWeight, TableEdgeId>::RelaxThroughEdge(parallel::ThreadPool &thread_pool,
+                                                                    EdgeId edge_id) {
+        const auto &edge = graph_.GetEdge(edge_id);
+        const auto edge_weight = static_cast<TableWeight>(edge.weight);
+        // строка конца ребра не меняется: маршрут через ребро вернулся бы в начало маршрута
+        const TableWeight *weights_through = &weights_[GetIndex(edge.to, 0)];
+        const TableEdgeId *prev_edges_through = &prev_edges_[GetIndex(edge.to, 0)];
+        thread_pool.ParallelFor(vertex_count_, [&](size_t from) {
+            const TableWeight weight_from = weights_[GetIndex(from, edge.from)];
+            // если маршрут до конца ребра не улучшился, через ребро не улучшится ни один маршрут строки
+            if (weight_from == NO_ROUTE || !(weight_from + edge_weight < weights_[GetIndex(from, edge.to)])) {
+                return;
+            }
+            TableWeight *weights_row = &weights_[GetIndex(from, 0)];
+            TableEdgeId *prev_edges_row = &prev_edges_[GetIndex(from, 0)];
+            for (VertexId to = 0; to < vertex_count_; ++to) {
+                if (weights_through[to] == NO_ROUTE) {
+                    continue;
+                }
+                const TableWeight candidate_weight = weight_from + edge_weight + weights_through[to];
+                if (candidate_weight < weights_row[to]) {
+                    weights_row[to] = candidate_weight;
+                    prev_edges_row[to] = to == edge.to ? static_cast<TableEdgeId>(edge_id) : prev_edges_through[to];
+                }
+            }
+        });
+    }
+
+    template<typename Weight, typename TableWeight, typename TableEdgeId>
+    void Router<Weight, TableWeight, TableEdgeId>::RemoveEdgeRange(EdgeId first, EdgeId last) {
+        MakeTableOwned();
+        const auto shift = static_cast<TableEdgeId>(last - first);
+        for (TableEdgeId &prev_edge: prev_edges_) {
+            if (prev_edge != NO_EDGE && prev_edge >= last) {
+                prev_edge -= shift;
+            }
+        }
+    }
+
+    template<typename Weight, typename TableWeight, typename TableEdgeId>
+    std::optional<Weight> Router<Weight, TableWeight, TableEdgeId>::BuildRoutePath(VertexId from, VertexId to,
+                                                                                   std::vector<EdgeId> &edges) const {
+        if (from >= vertex_count_ || to >= vertex_count_) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        const size_t index = GetIndex(from, to);
+        if (table_weights_[index] == NO_ROUTE) {
             return std::nullopt;
         }
-        const Weight weight = route_internal_data->weight;
-        std::vector<EdgeId> edges;
-        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-             edge_id;
-             edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge) {
-            edges.push_back(*edge_id);
+        // вес пересчитывается по ребрам графа, чтобы не терять точность при узком TableWeight
+        Weight weight = ZERO_WEIGHT;
+        edges.clear();
+        for (TableEdgeId edge_id = table_prev_edges_[index]; edge_id != NO_EDGE;) {
+            const auto &edge = graph_.GetEdge(edge_id);
+            weight += edge.weight;
+            edges.push_back(edge_id);
+            edge_id = table_prev_edges_[GetIndex(from, edge.from)];
         }
         std::reverse(edges.begin(), edges.end());
 
-        return RouteInfo{weight, std::move(edges)};
+        return weight;
     }
 
-}  // namespace graph
\ No newline at end of file
+}  // namespace graph
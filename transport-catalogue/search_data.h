@@ -0,0 +1,83 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // рабочие буферы поиска по графу (Дейкстра и производные), переиспользуются между запросами:
+    // вместо очистки массивов при каждом поиске увеличивается номер поиска
+    template<typename Weight>
+    struct SearchData {
+        using HeapItem = std::pair<Weight, VertexId>;
+
+        static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+        std::vector<Weight> weights;  // лучший найденный вес до вершины
+        std::vector<EdgeId> prev_edges;  // последнее ребро лучшего пути до вершины
+        std::vector<uint32_t> marks;  // номер поиска, в котором вершина была достигнута
+        std::vector<HeapItem> heap;  // очередь с приоритетом на векторе
+        std::vector<Weight> estimates;  // оценка остатка пути для A*, размер задает сам поиск
+        uint32_t generation = 0;  // номер текущего поиска
+
+        // готовит буферы к новому поиску без их очистки
+        void Prepare(size_t vertex_count) {
+            if (marks.size() < vertex_count) {
+                weights.resize(vertex_count);
+                prev_edges.resize(vertex_count);
+                marks.resize(vertex_count, 0);
+            }
+            if (++generation == 0) {
+                // счетчик переполнился, старые отметки нужно сбросить
+                std::fill(marks.begin(), marks.end(), 0);
+                generation = 1;
+            }
+            heap.clear();
+        }
+
+        bool IsReached(VertexId vertex) const {
+            return marks[vertex] == generation;
+        }
+
+        // запоминает вес и ребро вершины и кладет ее в очередь с приоритетом priority
+        void Reach(VertexId vertex, Weight weight, EdgeId prev_edge, Weight priority) {
+            marks[vertex] = generation;
+            weights[vertex] = weight;
+            prev_edges[vertex] = prev_edge;
+            heap.emplace_back(priority, vertex);
+            std::push_heap(heap.begin(), heap.end(), std::greater<>{});
+        }
+
+        void Reach(VertexId vertex, Weight weight, EdgeId prev_edge) {
+            Reach(vertex, weight, prev_edge, weight);
+        }
+
+        HeapItem Pop() {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<>{});
+            HeapItem item = heap.back();
+            heap.pop_back();
+            return item;
+        }
+    };
+
+    // независимые наборы буферов одного потока, например для прямого и обратного поиска
+    enum class SearchSlot {
+        Forward,
+        Backward,
+        Auxiliary,
+        Count,
+    };
+
+    template<typename Weight>
+    SearchData<Weight> &GetThreadSearchData(SearchSlot slot = SearchSlot::Forward) {
+        static thread_local SearchData<Weight> search_data[static_cast<size_t>(SearchSlot::Count)];
+        return search_data[static_cast<size_t>(slot)];
+    }
+
+}  // namespace graph
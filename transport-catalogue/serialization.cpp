@@ -1,6 +1,55 @@
+#include <cstring>
 #include <fstream>
+#include <numeric>
+#include <type_traits>
+#include "mapped_file.h"
 #include "serialization.h"
 
+namespace {
+    // заголовок файла таблицы маршрутизатора; за ним с выравниванием идут матрицы весов и последних ребер
+    struct RouterTableHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t weight_size;  // sizeof типа веса таблицы
+        uint32_t edge_id_size;  // sizeof типа номера ребра таблицы
+        uint32_t weight_is_integer;  // 1 - целые веса фиксированной точки, 0 - вещественные
+        uint64_t vertex_count;
+        uint64_t edge_count;
+        uint64_t graph_hash;  // отпечаток ребер графа, по которому построена таблица
+        uint64_t weights_offset;  // смещения матриц от начала файла
+        uint64_t prev_edges_offset;
+    };
+
+    constexpr char ROUTER_TABLE_MAGIC[8] = "TCROUTE";
+    constexpr uint32_t ROUTER_TABLE_VERSION = 2;
+    constexpr uint64_t ROUTER_TABLE_ALIGNMENT = 4096;  // матрицы начинаются с границы страницы
+
+    uint64_t AlignUp(uint64_t offset) {
+        return (offset + ROUTER_TABLE_ALIGNMENT - 1) / ROUTER_TABLE_ALIGNMENT * ROUTER_TABLE_ALIGNMENT;
+    }
+
+    // FNV-1a по началу, концу и весу каждого ребра: таблица от другого графа с тем же числом вершин
+    // ссылалась бы на чужие ребра
+    template<typename Weight>
+    uint64_t ComputeGraphHash(const graph::DirectedWeightedGraph<Weight> &graph) {
+        uint64_t hash = 14695981039346656037ull;
+        const auto add_bytes = [&hash](const void *data, size_t size) {
+            const auto *bytes = static_cast<const unsigned char *>(data);
+            for (size_t i = 0; i < size; ++i) {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+        };
+        for (const auto &edge: graph.GetEdges()) {
+            const uint64_t from = edge.from;
+            const uint64_t to = edge.to;
+            add_bytes(&from, sizeof(from));
+            add_bytes(&to, sizeof(to));
+            add_bytes(&edge.weight, sizeof(edge.weight));
+        }
+        return hash;
+    }
+}
+
 Serialization::Serialization() {
 
 }
@@ -25,6 +74,87 @@ void Serialization::Deserialize(const std::filesystem::path &path, TransportCata
     DeserializeTC(s_t_c, t_c);
     DeserializeRS(s_t_c, m_r);
     DeserializeTR(s_t_c, t_r);
+    t_r.BindStops(t_c);
+    t_r.CreateTimetable(t_c);
+}
+
+//----------------------------------------------------------------------------
+void Serialization::SerializeRouterTable(const TransportRouter::TransportRouter &t_r,
+                                         const std::filesystem::path &path) const {
+    using AllPairsRouter = TransportRouter::TransportRouter::AllPairsRouter;
+    using TableWeight = AllPairsRouter::TableWeightType;
+    using TableEdgeId = AllPairsRouter::TableEdgeIdType;
+    const AllPairsRouter *router = t_r.GetAllPairsRouter();
+    if (!router) {
+        // файл от прежней базы не оставляется: process_requests отобразил бы его вместо маршрутизатора базы
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        throw std::runtime_error("router table file is supported only by all_pairs router with prev_edges table");
+    }
+    const uint64_t table_size = router->GetTableSize();
+    RouterTableHeader header{};
+    std::memcpy(header.magic, ROUTER_TABLE_MAGIC, sizeof(header.magic));
+    header.version = ROUTER_TABLE_VERSION;
+    header.weight_size = sizeof(TableWeight);
+    header.weight_is_integer = std::is_integral_v<TableWeight>;
+    header.edge_id_size = sizeof(TableEdgeId);
+    header.vertex_count = t_r.GetGraph().GetVertexCount();
+    header.edge_count = t_r.GetGraph().GetEdgeCount();
+    header.graph_hash = ComputeGraphHash(t_r.GetGraph());
+    header.weights_offset = AlignUp(sizeof(header));
+    header.prev_edges_offset = AlignUp(header.weights_offset + table_size * sizeof(TableWeight));
+
+    std::ofstream out(path, std::ios::binary);
+    const auto write_at = [&out](uint64_t offset, const void *data, uint64_t size) {
+        out.seekp(static_cast<std::streamoff>(offset));
+        out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+    };
+    write_at(0, &header, sizeof(header));
+    write_at(header.weights_offset, router->GetTableWeights(), table_size * sizeof(TableWeight));
+    write_at(header.prev_edges_offset, router->GetTablePrevEdges(), table_size * sizeof(TableEdgeId));
+    out.close();
+    if (!out) {
+        // недописанный файл не оставляется: его заголовок мог бы пройти проверку
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        throw std::runtime_error("router table file write failed");
+    }
+}
+
+//----------------------------------------------------------------------------
+void Serialization::MapRouterTable(const std::filesystem::path &path, TransportRouter::TransportRouter &t_r) const {
+    using AllPairsRouter = TransportRouter::TransportRouter::AllPairsRouter;
+    using TableWeight = AllPairsRouter::TableWeightType;
+    using TableEdgeId = AllPairsRouter::TableEdgeIdType;
+    // таблица заменяет маршрутизатор, поэтому подходит только базе с тем же типом маршрутизатора и таблицы
+    const domain::RoutingSettings &routing_settings = t_r.GetRoutingSettings();
+    if (routing_settings.router_type != domain::RouterType::AllPairs
+        || routing_settings.all_pairs_table != domain::AllPairsTable::PrevEdges) {
+        throw std::runtime_error("router table file is supported only by all_pairs router with prev_edges table");
+    }
+    auto file = MappedFile::Open(path);
+    RouterTableHeader header{};
+    if (file->GetSize() < sizeof(header)) {
+        throw std::runtime_error("router table file is too small");
+    }
+    std::memcpy(&header, file->GetData(), sizeof(header));
+    const uint64_t vertex_count = t_r.GetGraph().GetVertexCount();
+    const uint64_t table_size = vertex_count * vertex_count;
+    if (std::memcmp(header.magic, ROUTER_TABLE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != ROUTER_TABLE_VERSION
+        || header.weight_size != sizeof(TableWeight) || header.edge_id_size != sizeof(TableEdgeId)
+        || header.weight_is_integer != std::is_integral_v<TableWeight>
+        || header.vertex_count != vertex_count
+        || header.edge_count != t_r.GetGraph().GetEdgeCount()
+        || header.graph_hash != ComputeGraphHash(t_r.GetGraph())
+        || header.weights_offset % alignof(TableWeight) != 0 || header.prev_edges_offset % alignof(TableEdgeId) != 0
+        || header.weights_offset + table_size * sizeof(TableWeight) > file->GetSize()
+        || header.prev_edges_offset + table_size * sizeof(TableEdgeId) > file->GetSize()) {
+        throw std::runtime_error("router table file doesn't match the base");
+    }
+    const auto *weights = reinterpret_cast<const TableWeight *>(file->GetData() + header.weights_offset);
+    const auto *prev_edges = reinterpret_cast<const TableEdgeId *>(file->GetData() + header.prev_edges_offset);
+    t_r.SetAllPairsTable(weights, prev_edges, std::move(file));
 }
 
 //----------------------------------------------------------------------------
@@ -51,6 +181,9 @@ void Serialization::SerializeTC(t_c_srlz::TransportCatalogue &s_t_c,
         }
 
         s_bus.set_is_roundtrip(bus.is_round);
+        for (const double departure: bus.departures) {
+            s_bus.add_departures(departure);
+        }
         *s_t_c.add_list_bus() = std::move(s_bus);
     }
     for (const auto &struc: t_c.GetIndexRageStop()) {
@@ -99,15 +232,38 @@ Serialization::SerializeTR(t_c_srlz::TransportCatalogue &s_t_c, const TransportR
     s_t_c.mutable_t_r_()->mutable_routing_settings()->set_bus_velocity(t_r.GetRoutingSettings().bus_velocity);
     s_t_c.mutable_t_r_()->mutable_routing_settings()->set_bus_wait_time_minut(
             t_r.GetRoutingSettings().bus_wait_time_minut);
+    s_t_c.mutable_t_r_()->mutable_routing_settings()->set_router_type(
+            static_cast<t_r_srlz::RouterType>(t_r.GetRoutingSettings().router_type));
+    s_t_c.mutable_t_r_()->mutable_routing_settings()->set_store_router_table(
+            t_r.GetRoutingSettings().store_router_table);
+    s_t_c.mutable_t_r_()->mutable_routing_settings()->set_graph_model(
+            static_cast<t_r_srlz::GraphModel>(t_r.GetRoutingSettings().graph_model));
+    s_t_c.mutable_t_r_()->mutable_routing_settings()->set_route_cache_size(
+            t_r.GetRoutingSettings().route_cache_size);
+    s_t_c.mutable_t_r_()->mutable_routing_settings()->set_stop_order(
+            static_cast<t_r_srlz::StopOrder>(t_r.GetRoutingSettings().stop_order));
+    s_t_c.mutable_t_r_()->mutable_routing_settings()->set_all_pairs_table(
+            static_cast<t_r_srlz::AllPairsTableType>(t_r.GetRoutingSettings().all_pairs_table));
+    s_t_c.mutable_t_r_()->set_weight_scale(TransportRouter::ROUTE_WEIGHT_SCALE);
     for (const auto &edge_bus: t_r.GetEdgesBuses()) {
         t_r_srlz::EdgeAditionInfo edge_adition_info;
-        edge_adition_info.set_bus_name(std::string(edge_bus.bus_name));
+        edge_adition_info.set_bus_id(edge_bus.bus_id);
         edge_adition_info.set_count_spans(edge_bus.count_spans);
+        edge_adition_info.set_type(static_cast<t_r_srlz::EdgeType>(edge_bus.type));
         *s_t_c.mutable_t_r_()->add_edges_buses() = std::move(edge_adition_info);
     }
     for (const auto &id_stop: t_r.GetIdStopes()) {
         *s_t_c.mutable_t_r_()->add_id_stopes() = id_stop;
     }
+    // вершины есть только у остановок автобусов
+    std::vector<uint64_t> vertex_stop_ids(t_r.GetIdStopes().size());
+    for (size_t stop_id = 0; stop_id < t_r.GetStopVertices().size(); ++stop_id) {
+        if (const graph::VertexId vertex = t_r.GetStopVertices()[stop_id];
+                vertex != TransportRouter::TransportRouter::NO_VERTEX) {
+            vertex_stop_ids[vertex] = stop_id;
+        }
+    }
+    s_t_c.mutable_t_r_()->mutable_vertex_stop_ids()->Add(vertex_stop_ids.begin(), vertex_stop_ids.end());
     // граф
     s_t_c.mutable_t_r_()->mutable_graph()->set_vertex_count(t_r.GetGraph().GetVertexCount());
     for (const auto &edge: t_r.GetGraph().GetEdges()) {
@@ -117,6 +273,47 @@ Serialization::SerializeTR(t_c_srlz::TransportCatalogue &s_t_c, const TransportR
         s_edge.set_weight(edge.weight);
         *s_t_c.mutable_t_r_()->mutable_graph()->add_edges() = std::move(s_edge);
     }
+    // компоненты связности графа
+    const graph::ComponentLabels &components = t_r.GetComponentLabels();
+    t_r_srlz::ComponentLabels &s_components = *s_t_c.mutable_t_r_()->mutable_components();
+    s_components.mutable_strong()->Add(components.strong.begin(), components.strong.end());
+    s_components.mutable_weak()->Add(components.weak.begin(), components.weak.end());
+    // таблица маршрутизатора, рассчитывается здесь, чтобы не считать ее при обработке запросов
+    if (t_r.GetRoutingSettings().store_router_table) {
+        if (const auto *router = t_r.GetAllPairsRouter(); router) {
+            t_r_srlz::AllPairsTable &s_table = *s_t_c.mutable_t_r_()->mutable_router_table();
+            const size_t table_size = router->GetTableSize();
+            if constexpr (std::is_integral_v<TransportRouter::RouteTableWeight>) {
+                s_table.mutable_fixed_weights()->Add(router->GetTableWeights(),
+                                                     router->GetTableWeights() + table_size);
+            } else {
+                s_table.mutable_weights()->Add(router->GetTableWeights(), router->GetTableWeights() + table_size);
+            }
+            s_table.mutable_prev_edges()->Add(router->GetTablePrevEdges(),
+                                              router->GetTablePrevEdges() + table_size);
+        } else if (const auto *next_hop_router = t_r.GetNextHopRouter(); next_hop_router) {
+            const graph::NextHopTable &table = next_hop_router->GetTable();
+            t_r_srlz::NextHopTable &s_table = *s_t_c.mutable_t_r_()->mutable_next_hop_table();
+            s_table.set_hop_width(table.hop_width);
+            s_table.set_hops(table.hops.data(), table.hops.size());
+            s_table.mutable_row_offsets()->Add(table.row_offsets.begin(), table.row_offsets.end());
+            s_table.mutable_run_starts()->Add(table.run_starts.begin(), table.run_starts.end());
+        }
+    }
+    // иерархия сжатия строится при создании базы, при обработке запросов только загружается
+    if (t_r.GetRoutingSettings().router_type == domain::RouterType::ContractionHierarchy) {
+        const graph::ContractionHierarchy<TransportRouter::RouteWeight> &hierarchy = t_r.GetContractionHierarchy();
+        t_r_srlz::ContractionHierarchy &s_hierarchy = *s_t_c.mutable_t_r_()->mutable_contraction_hierarchy();
+        s_hierarchy.mutable_ranks()->Add(hierarchy.ranks.begin(), hierarchy.ranks.end());
+        for (const auto &shortcut: hierarchy.shortcuts) {
+            t_r_srlz::Shortcut &s_shortcut = *s_hierarchy.add_shortcuts();
+            s_shortcut.set_from(shortcut.from);
+            s_shortcut.set_to(shortcut.to);
+            s_shortcut.set_weight(shortcut.weight);
+            s_shortcut.set_first(shortcut.first);
+            s_shortcut.set_second(shortcut.second);
+        }
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -141,6 +338,7 @@ void Serialization::DeserializeTC(const t_c_srlz::TransportCatalogue &s_t_c,
             bus.stops.push_back(t_c.FindStop(s_t_c.list_bus(i).list_name_stop(j)).value());
         }
         bus.is_round = s_t_c.list_bus(i).is_roundtrip();
+        bus.departures.assign(s_t_c.list_bus(i).departures().begin(), s_t_c.list_bus(i).departures().end());
         t_c.AddBus(std::move(bus));
     }
 
@@ -186,12 +384,36 @@ void Serialization::DeserializeRS(const t_c_srlz::TransportCatalogue &s_t_c, ren
 void
 Serialization::DeserializeTR(const t_c_srlz::TransportCatalogue &s_t_c, TransportRouter::TransportRouter &t_r) const {
     t_r.SetRoutingSettings({.bus_wait_time_minut = s_t_c.t_r_().routing_settings().bus_wait_time_minut(),
-                                   .bus_velocity = s_t_c.t_r_().routing_settings().bus_velocity()});
+                                   .bus_velocity = s_t_c.t_r_().routing_settings().bus_velocity(),
+                                   .router_type = static_cast<domain::RouterType>(
+                                           s_t_c.t_r_().routing_settings().router_type()),
+                                   .store_router_table = s_t_c.t_r_().routing_settings().store_router_table(),
+                                   .graph_model = static_cast<domain::GraphModel>(
+                                           s_t_c.t_r_().routing_settings().graph_model()),
+                                   .route_cache_size = s_t_c.t_r_().routing_settings().route_cache_size(),
+                                   .stop_order = static_cast<domain::StopOrder>(
+                                           s_t_c.t_r_().routing_settings().stop_order()),
+                                   .all_pairs_table = static_cast<domain::AllPairsTable>(
+                                           s_t_c.t_r_().routing_settings().all_pairs_table())});
 
+    // веса графа в базе записаны в единицах сборки, которая ее создала; в старых базах масштаб не записан
+    const double weight_scale = s_t_c.t_r_().weight_scale() > 0 ? s_t_c.t_r_().weight_scale() : 1;
+    if (weight_scale != TransportRouter::ROUTE_WEIGHT_SCALE) {
+        throw std::runtime_error("base route weights don't match the route weight type of this build");
+    }
+
+    // в старых базах ребра ссылаются на автобус по имени
+    std::unordered_map<std::string_view, size_t> bus_ids;
+    for (int i = 0; i < s_t_c.list_bus_size(); ++i) {
+        bus_ids.emplace(s_t_c.list_bus(i).name(), i);
+    }
     std::vector<TransportRouter::TransportRouter::EdgeAditionInfo> edges_buses(s_t_c.t_r_().edges_buses_size());
     for (int i = 0; i < s_t_c.t_r_().edges_buses_size(); ++i) {
-        edges_buses[i].bus_name = s_t_c.t_r_().edges_buses(i).bus_name();
+        const auto &edge_bus = s_t_c.t_r_().edges_buses(i);
+        edges_buses[i].bus_id = edge_bus.bus_name().empty() ? edge_bus.bus_id() : bus_ids.at(edge_bus.bus_name());
         edges_buses[i].count_spans = s_t_c.t_r_().edges_buses(i).count_spans();
+        edges_buses[i].type = static_cast<TransportRouter::TransportRouter::EdgeType>(
+                s_t_c.t_r_().edges_buses(i).type());
     }
     t_r.SetEdgesBuses(std::move(edges_buses));
 
@@ -201,15 +423,67 @@ Serialization::DeserializeTR(const t_c_srlz::TransportCatalogue &s_t_c, Transpor
     }
     t_r.SetIdStopes(std::move(id_stopes));
 
-    graph::DirectedWeightedGraph<double> graph(s_t_c.t_r_().graph().vertex_count());
+    // в старых базах вершина есть у каждой остановки и совпадает с ее номером
+    std::vector<graph::VertexId> stop_vertices(s_t_c.list_stop_size(), TransportRouter::TransportRouter::NO_VERTEX);
+    if (s_t_c.t_r_().vertex_stop_ids_size() == s_t_c.t_r_().id_stopes_size()) {
+        for (int vertex = 0; vertex < s_t_c.t_r_().vertex_stop_ids_size(); ++vertex) {
+            stop_vertices.at(s_t_c.t_r_().vertex_stop_ids(vertex)) = vertex;
+        }
+    } else {
+        std::iota(stop_vertices.begin(), stop_vertices.end(), graph::VertexId{0});
+    }
+    t_r.SetStopVertices(std::move(stop_vertices));
+
+    graph::DirectedWeightedGraph<TransportRouter::RouteWeight> graph(s_t_c.t_r_().graph().vertex_count());
     for (int i = 0; i < s_t_c.t_r_().graph().edges_size(); ++i) {
-        graph::Edge<double> edge;
+        graph::Edge<TransportRouter::RouteWeight> edge;
         edge.from = s_t_c.t_r_().graph().edges(i).from();
         edge.to = s_t_c.t_r_().graph().edges(i).to();
-        edge.weight = s_t_c.t_r_().graph().edges(i).weight();
+        edge.weight = static_cast<TransportRouter::RouteWeight>(s_t_c.t_r_().graph().edges(i).weight());
         graph.AddEdge(std::move(edge));
     }
     t_r.SetGraph(std::move(graph));
+
+    if (s_t_c.t_r_().has_components()) {
+        const t_r_srlz::ComponentLabels &s_components = s_t_c.t_r_().components();
+        t_r.SetComponentLabels({{s_components.strong().begin(), s_components.strong().end()},
+                                {s_components.weak().begin(), s_components.weak().end()}});
+    }
+
+    if (s_t_c.t_r_().has_router_table()) {
+        const t_r_srlz::AllPairsTable &s_table = s_t_c.t_r_().router_table();
+        if constexpr (std::is_integral_v<TransportRouter::RouteTableWeight>) {
+            t_r.SetAllPairsTable({s_table.fixed_weights().begin(), s_table.fixed_weights().end()},
+                                 {s_table.prev_edges().begin(), s_table.prev_edges().end()});
+        } else {
+            t_r.SetAllPairsTable({s_table.weights().begin(), s_table.weights().end()},
+                                 {s_table.prev_edges().begin(), s_table.prev_edges().end()});
+        }
+    }
+
+    if (s_t_c.t_r_().has_next_hop_table()) {
+        const t_r_srlz::NextHopTable &s_table = s_t_c.t_r_().next_hop_table();
+        graph::NextHopTable table;
+        table.vertex_count = s_t_c.t_r_().graph().vertex_count();
+        table.hop_width = s_table.hop_width();
+        table.hops.assign(s_table.hops().begin(), s_table.hops().end());
+        table.row_offsets.assign(s_table.row_offsets().begin(), s_table.row_offsets().end());
+        table.run_starts.assign(s_table.run_starts().begin(), s_table.run_starts().end());
+        t_r.SetNextHopTable(std::move(table));
+    }
+
+    if (s_t_c.t_r_().has_contraction_hierarchy()) {
+        const t_r_srlz::ContractionHierarchy &s_hierarchy = s_t_c.t_r_().contraction_hierarchy();
+        graph::ContractionHierarchy<TransportRouter::RouteWeight> hierarchy;
+        hierarchy.ranks.assign(s_hierarchy.ranks().begin(), s_hierarchy.ranks().end());
+        hierarchy.shortcuts.reserve(s_hierarchy.shortcuts_size());
+        for (const auto &s_shortcut: s_hierarchy.shortcuts()) {
+            hierarchy.shortcuts.push_back({s_shortcut.from(), s_shortcut.to(),
+                                           static_cast<TransportRouter::RouteWeight>(s_shortcut.weight()),
+                                           s_shortcut.first(), s_shortcut.second()});
+        }
+        t_r.SetContractionHierarchy(std::move(hierarchy));
+    }
 }
 
 //----------------------------------------------------------------------------
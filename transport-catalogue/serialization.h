@@ -17,6 +17,14 @@ public:
     void Deserialize(const std::filesystem::path &path, TransportCatalogue::TransportCatalogue &t_c,
                      renderer::MapRenderer &m_r, TransportRouter::TransportRouter &t_r) const;
 
+    // записывает таблицу маршрутизатора всех пар в отдельный файл в сыром двоичном формате;
+    // исключение, если выбран другой маршрутизатор или другая таблица
+    void SerializeRouterTable(const TransportRouter::TransportRouter &t_r, const std::filesystem::path &path) const;
+
+    // отображает файл таблицы в память и отвечает на запросы прямо по нему, граф должен быть уже загружен;
+    // исключение, если база построена с другим маршрутизатором или файл от другого графа
+    void MapRouterTable(const std::filesystem::path &path, TransportRouter::TransportRouter &t_r) const;
+
 private:
     void SerializeTC(t_c_srlz::TransportCatalogue &s_t_c, const TransportCatalogue::TransportCatalogue &t_c) const;
 
@@ -0,0 +1,88 @@
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "json.h"
+
+using namespace std;
+
+namespace {
+    // допуск для чисел: веса фиксированной точки округляются до тысячных долей минуты на каждом ребре,
+    // в линейной модели графа ошибка накапливается по остановкам маршрута
+    constexpr double RELATIVE_TOLERANCE = 1e-4;
+    constexpr double ABSOLUTE_TOLERANCE = 1e-2;
+
+    // сравнивает узлы, при расхождении печатает путь к нему
+    bool CompareNodes(const json::Node &expected, const json::Node &actual, const string &path) {
+        if (expected.IsDouble() && actual.IsDouble()) {
+            const double lhs = expected.AsDouble();
+            const double rhs = actual.AsDouble();
+            if (abs(lhs - rhs) <= max(ABSOLUTE_TOLERANCE, RELATIVE_TOLERANCE * abs(lhs))) {
+                return true;
+            }
+            cerr << path << ": expected " << lhs << ", actual " << rhs << endl;
+            return false;
+        }
+        if (expected.IsArray() && actual.IsArray()) {
+            const auto &lhs = expected.AsArray();
+            const auto &rhs = actual.AsArray();
+            if (lhs.size() != rhs.size()) {
+                cerr << path << ": expected " << lhs.size() << " elements, actual " << rhs.size() << endl;
+                return false;
+            }
+            bool is_equal = true;
+            for (size_t i = 0; i < lhs.size(); ++i) {
+                is_equal = CompareNodes(lhs[i], rhs[i], path + "[" + to_string(i) + "]") && is_equal;
+            }
+            return is_equal;
+        }
+        if (expected.IsDict() && actual.IsDict()) {
+            const auto &lhs = expected.AsDict();
+            const auto &rhs = actual.AsDict();
+            bool is_equal = true;
+            for (const auto &[key, value]: lhs) {
+                if (const auto it = rhs.find(key); it == rhs.end()) {
+                    cerr << path << ": missing key " << key << endl;
+                    is_equal = false;
+                } else {
+                    is_equal = CompareNodes(value, it->second, path + "." + key) && is_equal;
+                }
+            }
+            for (const auto &[key, value]: rhs) {
+                if (lhs.count(key) == 0) {
+                    cerr << path << ": unexpected key " << key << endl;
+                    is_equal = false;
+                }
+            }
+            return is_equal;
+        }
+        if (expected != actual) {
+            cerr << path << ": values differ" << endl;
+            return false;
+        }
+        return true;
+    }
+
+    json::Document LoadFile(const char *path) {
+        ifstream in(path);
+        if (!in) {
+            throw runtime_error("can't open "s + path);
+        }
+        return json::Load(in);
+    }
+}
+
+// json_compare expected.json actual.json: 0 - документы совпадают с точностью до допуска для чисел
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        cerr << "Usage: json_compare expected.json actual.json" << endl;
+        return 2;
+    }
+    try {
+        return CompareNodes(LoadFile(argv[1]).GetRoot(), LoadFile(argv[2]).GetRoot(), "$") ? 0 : 1;
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 2;
+    }
+}
@@ -0,0 +1,88 @@
+# Запуск одного теста запросов: make_base по MAKE_BASE, process_requests по PROCESS_REQUESTS
+# и сравнение ответа с EXPECTED. Необязательные ROUTER, GRAPH_MODEL и STORE_ROUTER_TABLE дописываются
+# в routing_settings, чтобы один набор запросов проверял разные маршрутизаторы и модели графа.
+# ROUTER_TABLE_FILE дописывает файл таблицы маршрутизатора в serialization_settings обоих запусков.
+# STALE_MAKE_BASE - база, по которой до основной make_base пишется файл таблицы; основная make_base его
+# не перезаписывает, и process_requests отображает чужую таблицу.
+# ROUTE_CACHE_SIZE, STOP_ORDER и ALL_PAIRS_TABLE дописывают в routing_settings размер кэша маршрутов,
+# порядок вершин остановок и вид таблицы маршрутизатора всех пар.
+# EXPECTED_ERROR - вместо сравнения ответа make_base или process_requests должна завершиться с этой ошибкой.
+# EXPECTED_STDERR - регулярное выражение, которому должен соответствовать вывод process_requests в cerr.
+# База пишется в WORK_DIR: пути к ней в файлах запросов относительные.
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+set(router_table_setting "\"router_table_file\": \"router_table.bin\", ")
+
+# запуск режима mode программы с входом input; при EXPECTED_ERROR ошибка этого шага завершает тест успешно
+macro(run_program mode input)
+    execute_process(COMMAND ${PROGRAM} ${mode}
+            INPUT_FILE ${input}
+            OUTPUT_FILE ${WORK_DIR}/${mode}_output.json
+            ERROR_VARIABLE error
+            WORKING_DIRECTORY ${WORK_DIR}
+            RESULT_VARIABLE result)
+    if (NOT result EQUAL 0)
+        if (EXPECTED_ERROR AND error MATCHES "${EXPECTED_ERROR}")
+            return()
+        endif ()
+        message(FATAL_ERROR "${mode} failed: ${result}\n${error}")
+    endif ()
+endmacro()
+
+if (STALE_MAKE_BASE)
+    file(READ ${STALE_MAKE_BASE} stale_make_base)
+    string(REPLACE "\"serialization_settings\": {" "\"serialization_settings\": {${router_table_setting}"
+            stale_make_base "${stale_make_base}")
+    file(WRITE ${WORK_DIR}/stale_make_base.json "${stale_make_base}")
+    run_program(make_base ${WORK_DIR}/stale_make_base.json)
+endif ()
+
+file(READ ${MAKE_BASE} make_base)
+set(settings "")
+if (ROUTER)
+    string(APPEND settings "\"router\": \"${ROUTER}\", ")
+endif ()
+if (GRAPH_MODEL)
+    string(APPEND settings "\"graph_model\": \"${GRAPH_MODEL}\", ")
+endif ()
+if (STORE_ROUTER_TABLE)
+    string(APPEND settings "\"store_router_table\": true, ")
+endif ()
+if (ROUTE_CACHE_SIZE)
+    string(APPEND settings "\"route_cache_size\": ${ROUTE_CACHE_SIZE}, ")
+endif ()
+if (STOP_ORDER)
+    string(APPEND settings "\"stop_order\": \"${STOP_ORDER}\", ")
+endif ()
+if (ALL_PAIRS_TABLE)
+    string(APPEND settings "\"all_pairs_table\": \"${ALL_PAIRS_TABLE}\", ")
+endif ()
+string(REPLACE "\"routing_settings\": {" "\"routing_settings\": {${settings}" make_base "${make_base}")
+file(READ ${PROCESS_REQUESTS} process_requests)
+if (ROUTER_TABLE_FILE)
+    string(REPLACE "\"serialization_settings\": {" "\"serialization_settings\": {${router_table_setting}"
+            make_base "${make_base}")
+endif ()
+if (ROUTER_TABLE_FILE OR STALE_MAKE_BASE)
+    string(REPLACE "\"serialization_settings\": {" "\"serialization_settings\": {${router_table_setting}"
+            process_requests "${process_requests}")
+endif ()
+file(WRITE ${WORK_DIR}/make_base.json "${make_base}")
+file(WRITE ${WORK_DIR}/process_requests.json "${process_requests}")
+
+run_program(make_base ${WORK_DIR}/make_base.json)
+run_program(process_requests ${WORK_DIR}/process_requests.json)
+if (EXPECTED_ERROR)
+    message(FATAL_ERROR "expected error: ${EXPECTED_ERROR}")
+endif ()
+if (EXPECTED_STDERR AND NOT error MATCHES "${EXPECTED_STDERR}")
+    message(FATAL_ERROR "process_requests stderr doesn't match ${EXPECTED_STDERR}:\n${error}")
+endif ()
+
+execute_process(COMMAND ${COMPARE} ${EXPECTED} ${WORK_DIR}/process_requests_output.json
+        RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "output differs from ${EXPECTED}")
+endif ()
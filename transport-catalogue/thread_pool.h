@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+    // пул потоков для параллельной обработки независимых задач с индексами [0, count)
+    class ThreadPool {
+    public:
+        // thread_count == 0 - по числу ядер; вызывающий поток тоже участвует в работе
+        explicit ThreadPool(size_t thread_count = 0) {
+            if (thread_count == 0) {
+                thread_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+            }
+            workers_.reserve(thread_count - 1);
+            for (size_t i = 1; i < thread_count; ++i) {
+                workers_.emplace_back([this] { WorkerLoop(); });
+            }
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard lock(mutex_);
+                stop_ = true;
+            }
+            wake_up_.notify_all();
+            for (auto &worker: workers_) {
+                worker.join();
+            }
+        }
+
+        size_t GetThreadCount() const {
+            return workers_.size() + 1;
+        }
+
+        // вызывает func(i) для всех i из [0, count) и дожидается завершения всех вызовов
+        void ParallelFor(size_t count, const std::function<void(size_t)> &func) {
+            if (count == 0) {
+                return;
+            }
+            if (workers_.empty() || count == 1) {
+                for (size_t i = 0; i < count; ++i) {
+                    func(i);
+                }
+                return;
+            }
+            {
+                std::lock_guard lock(mutex_);
+                task_ = &func;
+                task_size_ = count;
+                next_index_ = 0;
+                active_workers_ = workers_.size();
+                exception_ = nullptr;
+                ++task_generation_;
+            }
+            wake_up_.notify_all();
+            RunTask(func, count);
+
+            std::unique_lock lock(mutex_);
+            task_done_.wait(lock, [this] { return active_workers_ == 0; });
+            task_ = nullptr;
+            if (exception_) {
+                std::rethrow_exception(exception_);
+            }
+        }
+
+    private:
+        void WorkerLoop() {
+            size_t seen_generation = 0;
+            while (true) {
+                const std::function<void(size_t)> *task = nullptr;
+                size_t task_size = 0;
+                {
+                    std::unique_lock lock(mutex_);
+                    wake_up_.wait(lock, [&] { return stop_ || task_generation_ != seen_generation; });
+                    if (stop_) {
+                        return;
+                    }
+                    seen_generation = task_generation_;
+                    task = task_;
+                    task_size = task_size_;
+                }
+                RunTask(*task, task_size);
+                {
+                    std::lock_guard lock(mutex_);
+                    --active_workers_;
+                }
+                task_done_.notify_one();
+            }
+        }
+
+        // разбирает индексы задачи, пока они не закончатся
+        void RunTask(const std::function<void(size_t)> &func, size_t count) {
+            for (size_t i = next_index_++; i < count; i = next_index_++) {
+                try {
+                    func(i);
+                } catch (...) {
+                    std::lock_guard lock(mutex_);
+                    if (!exception_) {
+                        exception_ = std::current_exception();
+                    }
+                }
+            }
+        }
+
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable wake_up_;
+        std::condition_variable task_done_;
+
+        const std::function<void(size_t)> *task_ = nullptr;
+        size_t task_size_ = 0;
+        std::atomic<size_t> next_index_ = 0;
+        size_t active_workers_ = 0;
+        size_t task_generation_ = 0;
+        std::exception_ptr exception_;
+        bool stop_ = false;
+    };
+
+}  // namespace parallel
@@ -84,6 +84,25 @@ namespace TransportCatalogue {
         AddBusesFromStop(buses_.back());
     }
 
+//----------------------------------------------------------------------------
+    bool TransportCatalogue::RemoveBus(std::string_view bus_name) {
+        const auto it = std::find_if(buses_.begin(), buses_.end(), [bus_name](const Bus &bus) {
+            return bus.name == bus_name;
+        });
+        if (it == buses_.end()) {
+            return false;
+        }
+        buses_.erase(it);
+        // удаление из середины deque сдвигает элементы, индексы строятся заново
+        index_buses_.clear();
+        buses_from_stop_.clear();
+        for (const auto &bus: buses_) {
+            index_buses_[bus.name] = &bus;
+            AddBusesFromStop(bus);
+        }
+        return true;
+    }
+
 //----------------------------------------------------------------------------
     std::optional<const Bus *> TransportCatalogue::FindBus(std::string_view bus_name) const {
         if (index_buses_.count(bus_name) == 0) {
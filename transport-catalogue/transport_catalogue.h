@@ -34,6 +34,9 @@ namespace TransportCatalogue {
 
         void AddBus(const Bus &bus);
 
+        // удаляет автобус, указатели на остальные автобусы становятся недействительными; false если автобуса нет
+        bool RemoveBus(std::string_view bus_name);
+
         void AddStop(const Stop &stop);
 
         void AddRangeStops(const StopsLenght &stops_lenght);
@@ -1,58 +1,811 @@
 #include "transport_router.h"
 
+#include <cmath>
+#include <numeric>
+#include <type_traits>
+
 namespace TransportRouter {
+//----------------------------------------------------------------------------
+    RouteWeight ToRouteWeight(double minutes) {
+        if constexpr (std::is_integral_v<RouteWeight>) {
+            // запас до половины диапазона нужен таблице всех пар для отсутствующих маршрутов
+            const double weight = std::round(minutes * ROUTE_WEIGHT_SCALE);
+            if (weight > static_cast<double>(std::numeric_limits<RouteWeight>::max() / 4)) {
+                throw std::out_of_range("Edge time doesn't fit into the fixed-point route weight");
+            }
+            return static_cast<RouteWeight>(weight);
+        } else {
+            return minutes;
+        }
+    }
+
+//----------------------------------------------------------------------------
+    double ToMinutes(RouteWeight weight) {
+        return weight / ROUTE_WEIGHT_SCALE;
+    }
+
 //----------------------------------------------------------------------------
     void TransportRouter::CreateGraph(const TransportCatalogue::TransportCatalogue &db) {
-        graph::DirectedWeightedGraph<double> graph(db.GetStops().size());
-        id_stopes_.resize(db.GetStops().size());
+        if (routing_settings_.graph_model == GraphModel::Linear) {
+            CreateGraphLinear(db);
+        } else {
+            CreateGraphComplete(db);
+        }
+        CreateTimetable(db);
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::CreateTimetable(const TransportCatalogue::TransportCatalogue &db) {
+        raptor::Raptor timetable(db, GetMetrMinFromKmH(routing_settings_.bus_velocity));
+        if (timetable.IsEmpty()) {
+            opt_timetable_.reset();
+        } else {
+            opt_timetable_ = std::move(timetable);
+        }
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::NumberStopVertices(const TransportCatalogue::TransportCatalogue &db) {
+        const auto &stops = db.GetStops();
+        // вершины получают только остановки, через которые ходят автобусы
+        std::vector<char> is_served(stops.size(), 0);
+        for (const auto &bus: db.GetBuses()) {
+            for (const Stop *stop: bus.stops) {
+                is_served[stop->id] = 1;
+            }
+        }
+        std::vector<const Stop *> order;
+        if (routing_settings_.stop_order == StopOrder::Bfs) {
+            order = OrderStopsByBuses(db, is_served);
+        } else {
+            for (const auto &stop: stops) {
+                if (is_served[stop.id]) {
+                    order.push_back(&stop);
+                }
+            }
+            if (routing_settings_.stop_order == StopOrder::Hilbert) {
+                OrderStopsByHilbertCurve(order);
+            }
+        }
+        stop_vertices_.assign(stops.size(), NO_VERTEX);
+        id_stopes_.clear();
+        id_stopes_.reserve(order.size());
+        for (const Stop *stop: order) {
+            stop_vertices_[stop->id] = id_stopes_.size();
+            id_stopes_.push_back(stop->name);
+        }
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::OrderStopsByHilbertCurve(std::vector<const Stop *> &stops) {
+        if (stops.empty()) {
+            return;
+        }
+        geo::Coordinates min = stops.front()->coord;
+        geo::Coordinates max = min;
+        for (const Stop *stop: stops) {
+            min = {std::min(min.lat, stop->coord.lat), std::min(min.lng, stop->coord.lng)};
+            max = {std::max(max.lat, stop->coord.lat), std::max(max.lng, stop->coord.lng)};
+        }
+        // номер на кривой считается один раз на остановку; при равных номерах порядок справочника сохраняется
+        std::vector<std::pair<uint32_t, const Stop *>> indexed(stops.size());
+        for (size_t i = 0; i < stops.size(); ++i) {
+            indexed[i] = {geo::ComputeHilbertIndex(stops[i]->coord, min, max), stops[i]};
+        }
+        std::stable_sort(indexed.begin(), indexed.end(), [](const auto &lhs, const auto &rhs) {
+            return lhs.first < rhs.first;
+        });
+        for (size_t i = 0; i < stops.size(); ++i) {
+            stops[i] = indexed[i].second;
+        }
+    }
+
+//----------------------------------------------------------------------------
+    std::vector<const Stop *> TransportRouter::OrderStopsByBuses(const TransportCatalogue::TransportCatalogue &db,
+                                                                 const std::vector<char> &is_served) {
+        const auto &stops = db.GetStops();
+        // соседи остановки - остановки до и после нее в маршрутах автобусов
+        std::vector<std::vector<size_t>> neighbours(stops.size());
+        for (const auto &bus: db.GetBuses()) {
+            for (size_t i = 0; i + 1 < bus.stops.size(); ++i) {
+                neighbours[bus.stops[i]->id].push_back(bus.stops[i + 1]->id);
+                neighbours[bus.stops[i + 1]->id].push_back(bus.stops[i]->id);
+            }
+        }
+        // обход в ширину из каждой еще не пройденной остановки по порядку справочника;
+        // order - и результат, и очередь обхода
+        std::vector<const Stop *> order;
+        std::vector<char> is_visited(stops.size(), 0);
+        for (const auto &start: stops) {
+            if (!is_served[start.id] || is_visited[start.id]) {
+                continue;
+            }
+            is_visited[start.id] = 1;
+            order.push_back(&start);
+            for (size_t head = order.size() - 1; head < order.size(); ++head) {
+                for (const size_t next: neighbours[order[head]->id]) {
+                    if (!is_visited[next]) {
+                        is_visited[next] = 1;
+                        order.push_back(&stops[next]);
+                    }
+                }
+            }
+        }
+        return order;
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::CreateGraphComplete(const TransportCatalogue::TransportCatalogue &db) {
+        NumberStopVertices(db);
+        std::vector<graph::Edge<RouteWeight>> edges;
+        BuildBusesEdges(db, edges, edges_buses_);
+        opt_graph_.emplace(id_stopes_.size(), std::move(edges));
+        components_ = graph::BuildComponentLabels(opt_graph_.value());
+        ClearRouteCache();
+        BindStops(db);
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::CreateGraphLinear(const TransportCatalogue::TransportCatalogue &db) {
+        NumberStopVertices(db);
+        size_t vertex_count = id_stopes_.size();
         for (const auto &bus: db.GetBuses()) {
+            vertex_count += bus.stops.size();
+        }
+        std::vector<graph::Edge<RouteWeight>> edges;
+        BuildBusesEdges(db, edges, edges_buses_);
+        opt_graph_.emplace(vertex_count, std::move(edges));
+        components_ = graph::BuildComponentLabels(opt_graph_.value());
+        ClearRouteCache();
+        BindStops(db);
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::BuildBusesEdges(const TransportCatalogue::TransportCatalogue &db,
+                                          std::vector<graph::Edge<RouteWeight>> &edges,
+                                          std::vector<EdgeAditionInfo> &edges_info) const {
+        const auto &buses = db.GetBuses();
+        // вершина первой позиции каждого автобуса в модели Linear
+        std::vector<graph::VertexId> first_ride_vertices(buses.size());
+        graph::VertexId ride_vertex = id_stopes_.size();
+        for (size_t i = 0; i < buses.size(); ++i) {
+            first_ride_vertices[i] = ride_vertex;
+            ride_vertex += buses[i].stops.size();
+        }
 
-            for (auto it_from = bus.stops.begin(); it_from != bus.stops.end(); ++it_from) {
-                const Stop *stop_from = *it_from;
-                double lengh = 0;
-                const Stop *prev_stop = stop_from;
-                id_stopes_[stop_from->id] = stop_from->name;
-                for (auto it_to = std::next(it_from); it_to != bus.stops.end(); ++it_to) {
-                    const Stop *stop_to = *it_to;
-                    lengh += db.GetRangeStops(prev_stop, stop_to);
-                    prev_stop = stop_to;
-                    double time_on_bus = lengh / GetMetrMinFromKmH(routing_settings_.bus_velocity); // minute
-                    // вес ребра учитывает и ожидание и время в пути, чтобы учитывать затраты на пересадки
-                    graph.AddEdge({stop_from->id, stop_to->id, (time_on_bus + routing_settings_.bus_wait_time_minut)});
-                    // запоминает имя автобуса и количество прогонов между остановками
-                    edges_buses_.push_back({bus.name, static_cast<size_t>(std::distance(it_from, it_to))});
+        // части из подряд идущих автобусов, у каждой части свои буферы
+        parallel::ThreadPool thread_pool(buses.size() < MIN_PARALLEL_BUSES ? 1 : 0);
+        const size_t part_count = std::min(buses.size(), thread_pool.GetThreadCount() * 4);
+        std::vector<std::vector<graph::Edge<RouteWeight>>> part_edges(part_count);
+        std::vector<std::vector<EdgeAditionInfo>> part_edges_info(part_count);
+        const auto part_begin = [&buses, part_count](size_t part) {
+            return buses.size() * part / part_count;
+        };
+        thread_pool.ParallelFor(part_count, [&](size_t part) {
+            for (size_t i = part_begin(part); i < part_begin(part + 1); ++i) {
+                if (routing_settings_.graph_model == GraphModel::Linear) {
+                    AddBusEdgesLinear(db, buses[i], i, first_ride_vertices[i], part_edges[part],
+                                      part_edges_info[part]);
+                } else {
+                    AddBusEdgesComplete(db, buses[i], i, part_edges[part], part_edges_info[part]);
                 }
             }
+        });
+
+        // склейка частей в порядке автобусов: смещения частей - префиксные суммы их размеров
+        std::vector<size_t> part_offsets(part_count + 1, edges.size());
+        for (size_t part = 0; part < part_count; ++part) {
+            part_offsets[part + 1] = part_offsets[part] + part_edges[part].size();
         }
-        opt_graph_ = std::move(graph);
+        edges.resize(part_offsets[part_count]);
+        edges_info.resize(part_offsets[part_count]);
+        thread_pool.ParallelFor(part_count, [&](size_t part) {
+            std::copy(part_edges[part].begin(), part_edges[part].end(), edges.begin() + part_offsets[part]);
+            std::move(part_edges_info[part].begin(), part_edges_info[part].end(),
+                      edges_info.begin() + part_offsets[part]);
+        });
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::AddBusEdgesComplete(const TransportCatalogue::TransportCatalogue &db, const Bus &bus,
+                                              size_t bus_id, std::vector<graph::Edge<RouteWeight>> &edges,
+                                              std::vector<EdgeAditionInfo> &edges_info) const {
+        for (auto it_from = bus.stops.begin(); it_from != bus.stops.end(); ++it_from) {
+            const Stop *stop_from = *it_from;
+            double lengh = 0;
+            const Stop *prev_stop = stop_from;
+            for (auto it_to = std::next(it_from); it_to != bus.stops.end(); ++it_to) {
+                const Stop *stop_to = *it_to;
+                lengh += db.GetRangeStops(prev_stop, stop_to);
+                prev_stop = stop_to;
+                double time_on_bus = lengh / GetMetrMinFromKmH(routing_settings_.bus_velocity); // minute
+                // вес ребра учитывает и ожидание и время в пути, чтобы учитывать затраты на пересадки
+                edges.push_back({stop_vertices_[stop_from->id], stop_vertices_[stop_to->id],
+                                 ToRouteWeight(time_on_bus + routing_settings_.bus_wait_time_minut)});
+                // запоминает номер автобуса и количество прогонов между остановками
+                edges_info.push_back({bus_id, static_cast<size_t>(std::distance(it_from, it_to)), EdgeType::Bus});
+            }
+        }
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::AddBusEdgesLinear(const TransportCatalogue::TransportCatalogue &db, const Bus &bus,
+                                            size_t bus_id, graph::VertexId first_ride_vertex,
+                                            std::vector<graph::Edge<RouteWeight>> &edges,
+                                            std::vector<EdgeAditionInfo> &edges_info) const {
+        const double velocity = GetMetrMinFromKmH(routing_settings_.bus_velocity);
+        const RouteWeight wait_time = ToRouteWeight(routing_settings_.bus_wait_time_minut);
+        const size_t bus_size = bus.stops.size();
+        graph::VertexId ride_vertex = first_ride_vertex;
+        for (size_t i = 0; i < bus_size; ++i, ++ride_vertex) {
+            const Stop *stop = bus.stops[i];
+            if (i + 1 < bus_size) {
+                // посадка с ожиданием и пролет до следующей остановки
+                edges.push_back({stop_vertices_[stop->id], ride_vertex, wait_time});
+                edges_info.push_back({bus_id, 0, EdgeType::Board});
+                const RouteWeight time_on_bus = ToRouteWeight(db.GetRangeStops(stop, bus.stops[i + 1]) / velocity);
+                edges.push_back({ride_vertex, ride_vertex + 1, time_on_bus});
+                edges_info.push_back({bus_id, 1, EdgeType::Ride});
+            }
+            if (i > 0) {
+                edges.push_back({ride_vertex, stop_vertices_[stop->id], RouteWeight{}});
+                edges_info.push_back({bus_id, 0, EdgeType::Alight});
+            }
+        }
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::RebuildGraph(const TransportCatalogue::TransportCatalogue &db) {
+        // маршрутизатор ссылается на граф и удаляется первым
+        up_router_.reset();
+        opt_hierarchy_.reset();
+        opt_graph_.reset();
+        edges_buses_.clear();
+        id_stopes_.clear();
+        CreateGraph(db);
+    }
+
+//----------------------------------------------------------------------------
+    std::pair<graph::EdgeId, graph::EdgeId> TransportRouter::FindBusEdges(size_t bus_id) const {
+        // ребра автобуса идут подряд
+        const auto is_bus_edge = [bus_id](const EdgeAditionInfo &info) {
+            return info.bus_id == bus_id;
+        };
+        const auto first = std::find_if(edges_buses_.begin(), edges_buses_.end(), is_bus_edge);
+        const auto last = std::find_if_not(first, edges_buses_.end(), is_bus_edge);
+        return {first - edges_buses_.begin(), last - edges_buses_.begin()};
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::ApplyEdgeWeights(const std::vector<std::pair<graph::EdgeId, RouteWeight>> &changes) {
+        auto &graph = opt_graph_.value();
+        AllPairsRouter *all_pairs = GetUpdatableAllPairsRouter();
+        if (!all_pairs) {
+            // остальные маршрутизаторы дешевле построить заново, иерархию - при первом запросе
+            for (const auto &[edge_id, weight]: changes) {
+                graph.SetEdgeWeight(edge_id, weight);
+            }
+            up_router_.reset();
+            opt_hierarchy_.reset();
+            ClearRouteCache();
+            return;
+        }
+        // сначала увеличения весов: пересчитываются строки, в деревьях маршрутов которых есть эти ребра
+        std::vector<graph::EdgeId> increased;
+        for (const auto &[edge_id, weight]: changes) {
+            if (graph.GetEdge(edge_id).weight < weight) {
+                increased.push_back(edge_id);
+            }
+        }
+        const std::vector<graph::VertexId> rows = all_pairs->GetRowsUsingEdges(increased);
+        for (const auto &[edge_id, weight]: changes) {
+            if (graph.GetEdge(edge_id).weight < weight) {
+                graph.SetEdgeWeight(edge_id, weight);
+            }
+        }
+        all_pairs->RecomputeRows(rows);
+        // затем уменьшения: маршруты улучшаются через ребра с новыми весами
+        std::vector<graph::EdgeId> decreased;
+        for (const auto &[edge_id, weight]: changes) {
+            if (weight < graph.GetEdge(edge_id).weight) {
+                graph.SetEdgeWeight(edge_id, weight);
+                decreased.push_back(edge_id);
+            }
+        }
+        all_pairs->RelaxThroughEdges(decreased);
+        ClearRouteCache();
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::UpdateDistance(const TransportCatalogue::TransportCatalogue &db, const Stop *stop_from,
+                                         const Stop *stop_to) {
+        std::vector<std::pair<graph::EdgeId, RouteWeight>> changes;
+        const auto &graph = opt_graph_.value();
+        for (size_t bus_id = 0; bus_id < db.GetBuses().size(); ++bus_id) {
+            const Bus &bus = db.GetBuses()[bus_id];
+            bool is_affected = false;
+            for (size_t i = 0; i + 1 < bus.stops.size() && !is_affected; ++i) {
+                is_affected = (bus.stops[i] == stop_from && bus.stops[i + 1] == stop_to)
+                              || (bus.stops[i] == stop_to && bus.stops[i + 1] == stop_from);
+            }
+            if (!is_affected) {
+                continue;
+            }
+            // ребра автобуса строятся заново в том же порядке и сравниваются с текущими
+            const auto [first, last] = FindBusEdges(bus_id);
+            std::vector<graph::Edge<RouteWeight>> edges;
+            std::vector<EdgeAditionInfo> edges_info;
+            if (routing_settings_.graph_model == GraphModel::Linear) {
+                // первое ребро автобуса - посадка на первой остановке в вершину его первой позиции
+                AddBusEdgesLinear(db, bus, bus_id, graph.GetEdge(first).to, edges, edges_info);
+            } else {
+                AddBusEdgesComplete(db, bus, bus_id, edges, edges_info);
+            }
+            if (edges.size() != last - first) {
+                throw std::logic_error("graph doesn't match the catalogue");
+            }
+            for (size_t i = 0; i < edges.size(); ++i) {
+                if (edges[i].weight != graph.GetEdge(first + i).weight) {
+                    changes.emplace_back(first + i, edges[i].weight);
+                }
+            }
+        }
+        ApplyEdgeWeights(changes);
+        CreateTimetable(db);
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::AddBus(const TransportCatalogue::TransportCatalogue &db, const Bus &bus) {
+        // в модели Linear у автобуса свои вершины, граф строится заново;
+        // так же, если автобус проходит через остановку, у которой еще нет вершины
+        const bool has_new_stops = std::any_of(bus.stops.begin(), bus.stops.end(), [this](const Stop *stop) {
+            return stop->id >= stop_vertices_.size() || stop_vertices_[stop->id] == NO_VERTEX;
+        });
+        if (routing_settings_.graph_model == GraphModel::Linear || has_new_stops) {
+            RebuildGraph(db);
+            return;
+        }
+        // автобус добавлен в конец справочника
+        std::vector<graph::Edge<RouteWeight>> edges;
+        AddBusEdgesComplete(db, bus, db.GetBuses().size() - 1, edges, edges_buses_);
+        bus_names_.push_back(bus.name);
+        auto &graph = opt_graph_.value();
+        const graph::EdgeId first = graph.GetEdgeCount();
+        for (const auto &edge: edges) {
+            graph.AddEdge(edge);
+        }
+        graph.Freeze();
+        components_ = graph::BuildComponentLabels(graph);
+
+        AllPairsRouter *all_pairs = GetUpdatableAllPairsRouter();
+        if (all_pairs) {
+            // новое ребро - ребро, вес которого уменьшился с бесконечности
+            std::vector<graph::EdgeId> added(graph.GetEdgeCount() - first);
+            std::iota(added.begin(), added.end(), first);
+            all_pairs->RelaxThroughEdges(added);
+        } else {
+            up_router_.reset();
+            opt_hierarchy_.reset();
+        }
+        ClearRouteCache();
+        CreateTimetable(db);
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::RemoveBus(const TransportCatalogue::TransportCatalogue &db, std::string_view bus_name) {
+        if (routing_settings_.graph_model == GraphModel::Linear) {
+            RebuildGraph(db);
+            return;
+        }
+        // номер удаленного автобуса; номера следующих за ним автобусов справочника уменьшились на один
+        const size_t bus_id = std::find(bus_names_.begin(), bus_names_.end(), bus_name) - bus_names_.begin();
+        if (bus_id == bus_names_.size()) {
+            CreateTimetable(db);
+            return;
+        }
+        const auto [first, last] = FindBusEdges(bus_id);
+        if (first != last) {
+            AllPairsRouter *all_pairs = GetUpdatableAllPairsRouter();
+            std::vector<graph::VertexId> rows;
+            if (all_pairs) {
+                std::vector<graph::EdgeId> removed(last - first);
+                std::iota(removed.begin(), removed.end(), first);
+                rows = all_pairs->GetRowsUsingEdges(removed);
+            }
+            // граф без ребер автобуса; объект графа тот же, ссылка маршрутизатора на него остается верной
+            const auto &old_graph = opt_graph_.value();
+            graph::DirectedWeightedGraph<RouteWeight> graph(old_graph.GetVertexCount());
+            for (graph::EdgeId edge_id = 0; edge_id < old_graph.GetEdgeCount(); ++edge_id) {
+                if (edge_id < first || edge_id >= last) {
+                    graph.AddEdge(old_graph.GetEdge(edge_id));
+                }
+            }
+            graph.Freeze();
+            opt_graph_ = std::move(graph);
+            components_ = graph::BuildComponentLabels(opt_graph_.value());
+            edges_buses_.erase(edges_buses_.begin() + first, edges_buses_.begin() + last);
+            if (all_pairs) {
+                all_pairs->RemoveEdgeRange(first, last);
+                all_pairs->RecomputeRows(rows);
+            } else {
+                up_router_.reset();
+                opt_hierarchy_.reset();
+            }
+        }
+        for (auto &edge_info: edges_buses_) {
+            edge_info.bus_id -= edge_info.bus_id > bus_id ? 1 : 0;
+        }
+        bus_names_.erase(bus_names_.begin() + bus_id);
+        // в готовых маршрутах сдвинулись и номера автобусов
+        ClearRouteCache();
+        CreateTimetable(db);
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::BindStops(const TransportCatalogue::TransportCatalogue &db) {
+        if (stop_vertices_.size() != db.GetStops().size()) {
+            throw std::logic_error("graph doesn't match the catalogue");
+        }
+        vertex_stops_.assign(id_stopes_.size(), nullptr);
+        vertex_stops_.reserve(opt_graph_.value().GetVertexCount());
+        for (const auto &stop: db.GetStops()) {
+            if (const graph::VertexId vertex = stop_vertices_[stop.id]; vertex != NO_VERTEX) {
+                vertex_stops_.at(vertex) = &stop;
+            }
+        }
+        if (routing_settings_.graph_model == GraphModel::Linear) {
+            // вершины позиций автобусов идут после вершин остановок в порядке автобусов справочника
+            for (const auto &bus: db.GetBuses()) {
+                vertex_stops_.insert(vertex_stops_.end(), bus.stops.begin(), bus.stops.end());
+            }
+        }
+        if (vertex_stops_.size() != opt_graph_.value().GetVertexCount()) {
+            throw std::logic_error("graph doesn't match the catalogue");
+        }
+        // в старых базах метки компонент не сохранены
+        if (components_.strong.size() != vertex_stops_.size()) {
+            components_ = graph::BuildComponentLabels(opt_graph_.value());
+        }
+        bus_names_.clear();
+        bus_names_.reserve(db.GetBuses().size());
+        for (const auto &bus: db.GetBuses()) {
+            bus_names_.push_back(bus.name);
+        }
+    }
+
+//----------------------------------------------------------------------------
+    double TransportRouter::ComputeTopSpeed() const {
+        double top_speed = 0;
+        for (const auto &edge: opt_graph_.value().GetEdges()) {
+            const double distance = ComputeDistance(vertex_stops_[edge.from], vertex_stops_[edge.to]);
+            if (distance == 0) {
+                continue;
+            }
+            if (edge.weight == 0) {
+                // мгновенное перемещение, оценка может быть только нулевой
+                return std::numeric_limits<double>::infinity();
+            }
+            top_speed = std::max(top_speed, distance / edge.weight);
+        }
+        return top_speed;
+    }
+
+//----------------------------------------------------------------------------
+    RoutStatPtr TransportRouter::GetRouteStat(size_t id_stop_from, size_t id_stop_to) const {
+        // в кэш не попадает: проверка дешевле обращения к нему
+        if (!MayReach(id_stop_from, id_stop_to)) {
+            return nullptr;
+        }
+        const auto build = [&]() -> RoutStatPtr {
+            auto rout_stat = std::make_shared<RoutStat>();
+            if (!BuildRouteStat(id_stop_from, id_stop_to, *rout_stat)) {
+                return nullptr;
+            }
+            return rout_stat;
+        };
+        if (!route_cache_) {
+            return build();
+        }
+        const std::pair<size_t, size_t> key{id_stop_from, id_stop_to};
+        if (auto cached = route_cache_->Get(key)) {
+            return std::move(*cached);
+        }
+        // отсутствие маршрута тоже кэшируется
+        RoutStatPtr rout_stat = build();
+        route_cache_->Put(key, rout_stat);
+        return rout_stat;
+    }
+
+//----------------------------------------------------------------------------
+    bool TransportRouter::MayReach(size_t id_stop_from, size_t id_stop_to) const {
+        const graph::VertexId from = stop_vertices_[id_stop_from];
+        const graph::VertexId to = stop_vertices_[id_stop_to];
+        // до остановки без вершины можно "доехать" только из нее самой
+        if (from == NO_VERTEX || to == NO_VERTEX) {
+            return id_stop_from == id_stop_to;
+        }
+        return components_.MayReach(from, to);
+    }
+
+//----------------------------------------------------------------------------
+    bool TransportRouter::BuildRouteStat(size_t id_stop_from, size_t id_stop_to, RoutStat &rout_stat) const {
+        // ребра пути пишутся в буфер потока
+        static thread_local std::vector<graph::EdgeId> edges;
+        const graph::VertexId from = stop_vertices_[id_stop_from];
+        const graph::VertexId to = stop_vertices_[id_stop_to];
+        if (from == NO_VERTEX || to == NO_VERTEX) {
+            // остановка без автобусов: маршрут есть только из нее в нее же, пустой
+            if (id_stop_from != id_stop_to) {
+                return false;
+            }
+            edges.clear();
+            FillRouteStat(RouteWeight{}, edges, rout_stat);
+            return true;
+        }
+        const std::optional<RouteWeight> weight = GetRouter()->BuildRoutePath(from, to, edges);
+        if (!weight) {
+            return false;
+        }
+        FillRouteStat(*weight, edges, rout_stat);
+        return true;
+    }
+
+//----------------------------------------------------------------------------
+    std::string_view TransportRouter::GetItemName(const RoutStat::Item &item) const {
+        return item.type == RoutStat::ItemType::Wait ? id_stopes_[item.name_id] : bus_names_[item.name_id];
+    }
+
+//----------------------------------------------------------------------------
+    std::vector<RoutStatPtr> TransportRouter::GetRouteStats(size_t id_stop_from,
+                                                            const std::vector<size_t> &ids_stop_to) const {
+        std::vector<RoutStatPtr> rout_stats(ids_stop_to.size());
+        // позиции остановок, маршрутов до которых нет в кэше
+        std::vector<size_t> missed;
+        std::vector<size_t> missed_to;
+        // повторы уже пропущенных остановок: позиция и номер в missed первого вхождения
+        std::vector<std::pair<size_t, size_t>> repeated;
+        std::unordered_map<size_t, size_t> missed_index;
+        for (size_t i = 0; i < ids_stop_to.size(); ++i) {
+            if (!MayReach(id_stop_from, ids_stop_to[i])) {
+                continue;
+            }
+            if (const auto it = missed_index.find(ids_stop_to[i]); it != missed_index.end()) {
+                repeated.emplace_back(i, it->second);
+                continue;
+            }
+            if (route_cache_) {
+                if (auto cached = route_cache_->Get({id_stop_from, ids_stop_to[i]})) {
+                    rout_stats[i] = std::move(*cached);
+                    continue;
+                }
+            }
+            missed_index.emplace(ids_stop_to[i], missed.size());
+            missed.push_back(i);
+            missed_to.push_back(ids_stop_to[i]);
+        }
+        if (missed.empty()) {
+            return rout_stats;
+        }
+        // пакетный запрос только там, где маршрутизатор ищет все цели одним поиском
+        const auto &router = GetRouter();
+        std::vector<OptRouteInfo> route_infos;
+        if (missed.size() > 1 && router->HasBatchSearch() && stop_vertices_[id_stop_from] != NO_VERTEX) {
+            // после проверки компонент у всех целей есть вершины
+            std::vector<graph::VertexId> vertices_to(missed_to.size());
+            for (size_t i = 0; i < missed_to.size(); ++i) {
+                vertices_to[i] = stop_vertices_[missed_to[i]];
+            }
+            route_infos = router->BuildRoutes(stop_vertices_[id_stop_from], vertices_to);
+        }
+        for (size_t i = 0; i < missed.size(); ++i) {
+            if (route_infos.empty()) {
+                auto rout_stat = std::make_shared<RoutStat>();
+                if (BuildRouteStat(id_stop_from, missed_to[i], *rout_stat)) {
+                    rout_stats[missed[i]] = std::move(rout_stat);
+                }
+            } else {
+                rout_stats[missed[i]] = MakeRouteStat(route_infos[i]);
+            }
+            if (route_cache_) {
+                route_cache_->Put({id_stop_from, missed_to[i]}, rout_stats[missed[i]]);
+            }
+        }
+        // повтор берется из кэша, как если бы запросы шли по одному; вытесненная запись - из результата пакета
+        for (const auto &[position, missed_position]: repeated) {
+            std::optional<RoutStatPtr> cached;
+            if (route_cache_) {
+                cached = route_cache_->Get({id_stop_from, ids_stop_to[position]});
+            }
+            rout_stats[position] = cached ? std::move(*cached) : rout_stats[missed[missed_position]];
+        }
+        return rout_stats;
+    }
+
+//----------------------------------------------------------------------------
+    RoutStatPtr TransportRouter::GetTimetableRouteStat(size_t id_stop_from, size_t id_stop_to,
+                                                       double departure_time) const {
+        // автобусы с расписанием - часть автобусов графа, несвязанные в графе остановки не связаны и по ним
+        if (!opt_timetable_ || !MayReach(id_stop_from, id_stop_to)) {
+            return nullptr;
+        }
+        const auto journey = opt_timetable_->BuildJourney(id_stop_from, id_stop_to, departure_time);
+        if (!journey) {
+            return nullptr;
+        }
+        std::vector<RoutStat::Item> items;
+        items.reserve(journey->legs.size() * 2);
+        for (const raptor::Leg &leg: journey->legs) {
+            items.push_back({RoutStat::ItemType::Wait, leg.wait_time, 0, stop_vertices_[leg.board_stop_id]});
+            items.push_back({RoutStat::ItemType::Bus, leg.ride_time, leg.span_count, leg.bus_id});
+        }
+        return std::make_shared<const RoutStat>(RoutStat{journey->arrival_time - journey->departure_time,
+                                                         std::move(items)});
+    }
+
+//----------------------------------------------------------------------------
+    std::vector<RoutStatPtr> TransportRouter::GetAlternativeRouteStats(size_t id_stop_from, size_t id_stop_to,
+                                                                       size_t count) const {
+        if (!MayReach(id_stop_from, id_stop_to)) {
+            return {};
+        }
+        const graph::VertexId vertex = stop_vertices_[id_stop_from];
+        if (vertex == NO_VERTEX) {
+            // остановка без автобусов, маршрут из нее в нее же - только пустой
+            return std::vector<RoutStatPtr>(std::min<size_t>(count, 1), std::make_shared<const RoutStat>());
+        }
+        // маршруты по параллельным ребрам одного автобуса выглядят одинаково, различаются описания маршрутов
+        const auto route_items = [this](const std::vector<graph::EdgeId> &edges) {
+            RoutStat rout_stat;
+            FillRouteStat(RouteWeight{}, edges, rout_stat);
+            return std::move(rout_stat.items);
+        };
+        const auto route_infos = graph::KShortestPaths<RouteWeight>(opt_graph_.value())
+                .BuildRoutes(vertex, stop_vertices_[id_stop_to], count, route_items);
+        std::vector<RoutStatPtr> rout_stats;
+        rout_stats.reserve(route_infos.size());
+        for (const auto &route_info: route_infos) {
+            rout_stats.push_back(MakeRouteStat(route_info));
+        }
+        return rout_stats;
+    }
+
+//----------------------------------------------------------------------------
+    TimeMatrix TransportRouter::GetTimeMatrix(const std::vector<size_t> &ids_stop_from,
+                                              const std::vector<size_t> &ids_stop_to) const {
+        // маршрутизатор создается до запуска потоков
+        const graph::RouterBase<RouteWeight> &router = *GetRouter();
+        // маршрутизатор ищет только до остановок с вершинами, columns - их столбцы
+        std::vector<graph::VertexId> to;
+        std::vector<size_t> columns;
+        for (size_t column = 0; column < ids_stop_to.size(); ++column) {
+            if (const graph::VertexId vertex = stop_vertices_[ids_stop_to[column]]; vertex != NO_VERTEX) {
+                to.push_back(vertex);
+                columns.push_back(column);
+            }
+        }
+        TimeMatrix time_matrix(ids_stop_from.size());
+        const auto compute_row = [&](size_t row) {
+            auto &times = time_matrix[row];
+            times.assign(ids_stop_to.size(), std::nullopt);
+            const graph::VertexId from = stop_vertices_[ids_stop_from[row]];
+            if (from == NO_VERTEX) {
+                // из остановки без автобусов - только в нее же
+                for (size_t column = 0; column < ids_stop_to.size(); ++column) {
+                    if (ids_stop_to[column] == ids_stop_from[row]) {
+                        times[column] = 0.0;
+                    }
+                }
+                return;
+            }
+            const auto route_infos = router.BuildRoutes(from, to);
+            for (size_t i = 0; i < route_infos.size(); ++i) {
+                if (route_infos[i]) {
+                    times[columns[i]] = ToMinutes(route_infos[i]->weight);
+                }
+            }
+        };
+        if (ids_stop_from.size() > 1) {
+            parallel::ThreadPool thread_pool;
+            thread_pool.ParallelFor(ids_stop_from.size(), compute_row);
+        } else if (!ids_stop_from.empty()) {
+            compute_row(0);
+        }
+        return time_matrix;
     }
 
 //----------------------------------------------------------------------------
-    std::optional<RoutStat> TransportRouter::GetRouteStat(size_t id_stop_from, size_t id_stop_to) const {
-        // попытка построить маршрут
-        const OptRouteInfo opt_route_info = GetRouter()->BuildRoute(id_stop_from, id_stop_to);
+    std::vector<ReachableStop> TransportRouter::GetReachableStops(const Stop *stop_from, double max_time) const {
+        std::vector<ReachableStop> stops;
+        const graph::VertexId vertex_from = stop_vertices_[stop_from->id];
+        if (vertex_from == NO_VERTEX) {
+            // через остановку не ходят автобусы, достижима только она сама
+            if (max_time >= 0) {
+                stops.push_back({stop_from->name, 0});
+            }
+            return stops;
+        }
+        // вершины остановок - первые id_stopes_.size() вершин графа, остальные вершины модели Linear пропускаются
+        // целая граница округляется вниз и ограничивается диапазоном веса
+        RouteWeight max_weight{};
+        if constexpr (std::is_integral_v<RouteWeight>) {
+            max_weight = max_time * ROUTE_WEIGHT_SCALE < std::numeric_limits<RouteWeight>::max()
+                         ? static_cast<RouteWeight>(std::floor(max_time * ROUTE_WEIGHT_SCALE))
+                         : std::numeric_limits<RouteWeight>::max();
+        } else {
+            max_weight = max_time;
+        }
+        graph::ForEachReachable<RouteWeight>(opt_graph_.value(), vertex_from, max_weight,
+                                             [&](graph::VertexId vertex, RouteWeight weight) {
+                                                 if (vertex < id_stopes_.size()) {
+                                                     stops.push_back({vertex_stops_[vertex]->name, ToMinutes(weight)});
+                                                 }
+                                             });
+        return stops;
+    }
+
+//----------------------------------------------------------------------------
+    size_t TransportRouter::GetRouteCacheHits() const {
+        return route_cache_ ? route_cache_->GetHits() : 0;
+    }
+
+//----------------------------------------------------------------------------
+    size_t TransportRouter::GetRouteCacheMisses() const {
+        return route_cache_ ? route_cache_->GetMisses() : 0;
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::ClearRouteCache() {
+        if (route_cache_) {
+            route_cache_->Clear();
+        }
+    }
+
+//----------------------------------------------------------------------------
+    RoutStatPtr TransportRouter::MakeRouteStat(const OptRouteInfo &opt_route_info) const {
         // проверка маршрута
         if (!opt_route_info.has_value()) {
-            return std::nullopt;
+            return nullptr;
         }
+        auto rout_stat = std::make_shared<RoutStat>();
+        FillRouteStat(opt_route_info->weight, opt_route_info->edges, *rout_stat);
+        return rout_stat;
+    }
 
-        const graph::Router<double>::RouteInfo &route_info = opt_route_info.value();
-        double total_time = route_info.weight;
+//----------------------------------------------------------------------------
+    void TransportRouter::FillRouteStat(RouteWeight weight, const std::vector<graph::EdgeId> &edges,
+                                        RoutStat &rout_stat) const {
+        using ItemType = RoutStat::ItemType;
+        const double wait_time = routing_settings_.bus_wait_time_minut;
+        rout_stat.total_time = ToMinutes(weight);
         // хранит данные для вывода в поток
-        std::vector<RoutStat::VariantItem> items;
-        for (const auto &edge_id: route_info.edges) {
+        std::vector<RoutStat::Item> &items = rout_stat.items;
+        items.clear();
+        // поездка, собираемая из ребер модели Linear: от посадки до высадки
+        RoutStat::Item ride;
+        for (const auto &edge_id: edges) {
             // ребро по id
             const auto &edge = opt_graph_.value().GetEdge(edge_id);
             // номер автобуса едущий по этому ребру и количество прогонов в ребре
-            const auto [bus_num, span_count] = edges_buses_[edge_id];
-            items.push_back(RoutStat::ItemsWait{"Wait", static_cast<double>(routing_settings_.bus_wait_time_minut),
-                                                std::string(id_stopes_[edge.from])});
-            // вычитаем из веса время ожидания
-            items.push_back(
-                    RoutStat::ItemsBus{"Bus", edge.weight - static_cast<double>(routing_settings_.bus_wait_time_minut),
-                                       span_count, std::string(bus_num)});
+            const auto &[bus_id, span_count, type] = edges_buses_[edge_id];
+            switch (type) {
+                case EdgeType::Bus:
+                    items.push_back({ItemType::Wait, wait_time, 0, edge.from});
+                    // вычитаем из веса время ожидания
+                    items.push_back({ItemType::Bus, ToMinutes(edge.weight) - wait_time, span_count, bus_id});
+                    break;
+                case EdgeType::Board:
+                    items.push_back({ItemType::Wait, ToMinutes(edge.weight), 0, edge.from});
+                    ride = {ItemType::Bus, 0, 0, bus_id};
+                    break;
+                case EdgeType::Ride:
+                    ride.time += ToMinutes(edge.weight);
+                    ride.span_count += span_count;
+                    break;
+                case EdgeType::Alight:
+                    items.push_back(ride);
+                    break;
+            }
         }
-        return RoutStat{total_time, items};
     }
 
 //----------------------------------------------------------------------------
@@ -80,7 +833,12 @@ namespace TransportRouter {
     }
 
 //----------------------------------------------------------------------------
-    const graph::DirectedWeightedGraph<double> &TransportRouter::GetGraph() const {
+    const std::vector<graph::VertexId> &TransportRouter::GetStopVertices() const {
+        return stop_vertices_;
+    }
+
+//----------------------------------------------------------------------------
+    const graph::DirectedWeightedGraph<RouteWeight> &TransportRouter::GetGraph() const {
         return opt_graph_.value();
     }
 
@@ -91,12 +849,94 @@ namespace TransportRouter {
 
 //----------------------------------------------------------------------------
     void TransportRouter::SetIdStopes(std::vector<std::string> &&id_stopes) {
-        id_stopes_ = id_stopes;
+        id_stopes_ = std::move(id_stopes);
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::SetStopVertices(std::vector<graph::VertexId> &&stop_vertices) {
+        stop_vertices_ = std::move(stop_vertices);
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::SetGraph(graph::DirectedWeightedGraph<RouteWeight> &&graph) {
+        graph.Freeze();
+        opt_graph_ = std::move(graph);
+        // метки задаются из базы или считаются в BindStops
+        components_ = {};
+        ClearRouteCache();
+    }
+
+//----------------------------------------------------------------------------
+    bool TransportRouter::HasAllPairsTable(AllPairsTable table) const {
+        return routing_settings_.router_type == RouterType::AllPairs && routing_settings_.all_pairs_table == table;
     }
 
 //----------------------------------------------------------------------------
-    void TransportRouter::SetGraph(graph::DirectedWeightedGraph<double> &&graph) {
-        opt_graph_ = graph;
+    TransportRouter::AllPairsRouter *TransportRouter::GetUpdatableAllPairsRouter() {
+        return HasAllPairsTable(AllPairsTable::PrevEdges) ? static_cast<AllPairsRouter *>(up_router_.get()) : nullptr;
+    }
+
+//----------------------------------------------------------------------------
+    const TransportRouter::AllPairsRouter *TransportRouter::GetAllPairsRouter() const {
+        if (!HasAllPairsTable(AllPairsTable::PrevEdges)) {
+            return nullptr;
+        }
+        return static_cast<const AllPairsRouter *>(GetRouter().get());
+    }
+
+//----------------------------------------------------------------------------
+    const graph::NextHopRouter<RouteWeight> *TransportRouter::GetNextHopRouter() const {
+        if (routing_settings_.router_type != RouterType::AllPairs || HasAllPairsTable(AllPairsTable::PrevEdges)) {
+            return nullptr;
+        }
+        return static_cast<const graph::NextHopRouter<RouteWeight> *>(GetRouter().get());
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::SetNextHopTable(graph::NextHopTable &&table) {
+        up_router_ = std::make_unique<graph::NextHopRouter<RouteWeight>>(opt_graph_.value(), std::move(table));
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::SetAllPairsTable(std::vector<AllPairsRouter::TableWeightType> &&weights,
+                                           std::vector<AllPairsRouter::TableEdgeIdType> &&prev_edges) {
+        up_router_ = std::make_unique<AllPairsRouter>(opt_graph_.value(), std::move(weights), std::move(prev_edges));
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::SetAllPairsTable(const AllPairsRouter::TableWeightType *weights,
+                                           const AllPairsRouter::TableEdgeIdType *prev_edges,
+                                           std::shared_ptr<const void> table_holder) {
+        up_router_ = std::make_unique<AllPairsRouter>(opt_graph_.value(), weights, prev_edges,
+                                                      std::move(table_holder));
+    }
+
+//----------------------------------------------------------------------------
+    const graph::ContractionHierarchy<RouteWeight> &TransportRouter::GetContractionHierarchy() const {
+        if (!opt_hierarchy_) {
+            opt_hierarchy_ = graph::ContractionHierarchyBuilder<RouteWeight>(opt_graph_.value()).Build();
+        }
+        return *opt_hierarchy_;
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::SetContractionHierarchy(graph::ContractionHierarchy<RouteWeight> &&hierarchy) {
+        opt_hierarchy_ = std::move(hierarchy);
+        up_router_.reset();
+    }
+
+//----------------------------------------------------------------------------
+    const graph::ComponentLabels &TransportRouter::GetComponentLabels() const {
+        return components_;
+    }
+
+//----------------------------------------------------------------------------
+    void TransportRouter::SetComponentLabels(graph::ComponentLabels &&labels) {
+        const size_t vertex_count = opt_graph_.value().GetVertexCount();
+        if (labels.strong.size() != vertex_count || labels.weak.size() != vertex_count) {
+            throw std::logic_error("component labels don't match the graph");
+        }
+        components_ = std::move(labels);
     }
 
 //----------------------------------------------------------------------------
@@ -107,10 +947,15 @@ namespace TransportRouter {
 //----------------------------------------------------------------------------
     void TransportRouter::SetRoutingSettings(RoutingSettings &&routing_settings) {
         routing_settings_ = std::move(routing_settings);
+        if (routing_settings_.route_cache_size > 0) {
+            route_cache_ = std::make_unique<RouteCache>(routing_settings_.route_cache_size);
+        } else {
+            route_cache_.reset();
+        }
     }
 
 //----------------------------------------------------------------------------
-    const std::unique_ptr<graph::Router<double>> &TransportRouter::GetRouter() const {
+    const std::unique_ptr<graph::RouterBase<RouteWeight>> &TransportRouter::GetRouter() const {
         // граф создан
         if (GetGraphIsNoInit()) {
             std::cerr << " ! opt_graph_.has_value()" << std::endl;
@@ -118,7 +963,47 @@ namespace TransportRouter {
         }
         // создает маршрутизатор если его еще нет
         if (!up_router_) {
-            up_router_ = std::make_unique<graph::Router<double>>(opt_graph_.value());
+            switch (routing_settings_.router_type) {
+                case RouterType::Dijkstra:
+                    up_router_ = std::make_unique<graph::DijkstraRouter<RouteWeight>>(opt_graph_.value());
+                    break;
+                case RouterType::ContractionHierarchy:
+                    up_router_ = std::make_unique<graph::ContractionHierarchyRouter<RouteWeight>>(
+                            opt_graph_.value(), GetContractionHierarchy());
+                    break;
+                case RouterType::AStar: {
+                    const double top_speed = ComputeTopSpeed();
+                    // оценка: время на путь по прямой до цели с наибольшей скоростью сети
+                    // целая оценка округляется вниз, так она остается согласованной с целыми весами ребер
+                    auto heuristic = [this, top_speed](graph::VertexId vertex, graph::VertexId to) {
+                        const double estimate = top_speed > 0
+                                                ? ComputeDistance(vertex_stops_[vertex], vertex_stops_[to]) / top_speed
+                                                : 0.;
+                        if constexpr (std::is_integral_v<RouteWeight>) {
+                            return static_cast<RouteWeight>(std::floor(estimate));
+                        } else {
+                            return estimate;
+                        }
+                    };
+                    up_router_ = std::make_unique<graph::AStarRouter<RouteWeight>>(opt_graph_.value(), heuristic);
+                    break;
+                }
+                case RouterType::Bidirectional:
+                    up_router_ = std::make_unique<graph::BidirectionalRouter<RouteWeight>>(opt_graph_.value());
+                    break;
+                case RouterType::AllPairs:
+                default:
+                    if (routing_settings_.all_pairs_table == AllPairsTable::PrevEdges) {
+                        up_router_ = std::make_unique<AllPairsRouter>(opt_graph_.value());
+                    } else {
+                        up_router_ = std::make_unique<graph::NextHopRouter<RouteWeight>>(
+                                opt_graph_.value(),
+                                graph::BuildNextHopTable(opt_graph_.value(),
+                                                         routing_settings_.all_pairs_table
+                                                         == AllPairsTable::NextHopRuns));
+                    }
+                    break;
+            }
         }
         return up_router_;
     }
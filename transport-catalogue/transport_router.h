@@ -1,36 +1,111 @@
 #pragma once
 
 #include "graph.h"
+#include "graph_components.h"
 #include "router.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy.h"
+#include "a_star_router.h"
+#include "bidirectional_router.h"
+#include "k_shortest_paths.h"
+#include "next_hop_router.h"
+#include "raptor.h"
 #include "domain.h"
+#include "lru_cache.h"
 #include "transport_catalogue.h"
 #include "unordered_map"
 #include "unordered_set"
+#include <limits>
 #include <memory>
 
 namespace TransportRouter {
     using namespace domain;
 
+#ifdef TRANSPORT_ROUTER_FIXED_POINT
+    // вес ребра графа - время в тысячных долях минуты: сравнения весов точные, таблица всех пар из целых
+    using RouteWeight = int32_t;
+    using RouteTableWeight = int32_t;
+    inline constexpr double ROUTE_WEIGHT_SCALE = 1000;
+#else
+    // вес ребра графа - время в минутах
+    using RouteWeight = double;
+    using RouteTableWeight = float;
+    inline constexpr double ROUTE_WEIGHT_SCALE = 1;
+#endif
+
+    // вес ребра по времени в минутах; целый вес округляется до 1 / ROUTE_WEIGHT_SCALE минуты
+    RouteWeight ToRouteWeight(double minutes);
+
+    // время в минутах по весу; веса переводятся в минуты только при выводе
+    double ToMinutes(RouteWeight weight);
+
     class TransportRouter {
     public:
-        using OptRouteInfo = std::optional<graph::Router<double>::RouteInfo>;
+        using OptRouteInfo = std::optional<graph::RouterBase<RouteWeight>::RouteInfo>;
+        // таблица всех пар хранит веса в RouteTableWeight (float или целые) и номера ребер в uint32_t
+        using AllPairsRouter = graph::Router<RouteWeight, RouteTableWeight, uint32_t>;
+
+        // вершина остановки, через которую не ходят автобусы
+        static constexpr graph::VertexId NO_VERTEX = std::numeric_limits<graph::VertexId>::max();
+
+        // вид ребра графа
+        enum class EdgeType {
+            Bus, // ожидание и поездка от остановки до остановки (модель Complete)
+            Board, // ожидание и посадка в автобус (модель Linear)
+            Ride, // пролет между соседними остановками в автобусе (модель Linear)
+            Alight, // выход из автобуса на остановку (модель Linear)
+        };
 
         // дополнительная информация о ребре
         struct EdgeAditionInfo {
-            std::string bus_name; // имя автобуса едущего по ребру
+            size_t bus_id = 0; // номер автобуса едущего по ребру, он же номер автобуса в справочнике
             size_t count_spans = 0; // кол-во пролетов между остановками в этом ребре
+            EdgeType type = EdgeType::Bus;
         };
 
         TransportRouter() = default;
 
-        // создает граф
+        // создает граф по модели из routing_settings
         void CreateGraph(const TransportCatalogue::TransportCatalogue &db);
 
-        // возвращает маршрут и статистику по нему
-        std::optional<RoutStat> GetRouteStat(size_t id_stop_from, size_t id_stop_to) const;
+        // возвращает маршрут и статистику по нему, nullptr если маршрута нет;
+        // при включенном кэше повторные запросы той же пары остановок берутся из кэша;
+        // пары остановок из несвязанных компонент графа отбрасываются без поиска
+        RoutStatPtr GetRouteStat(size_t id_stop_from, size_t id_stop_to) const;
+
+        // строит маршрут в rout_stat вызывающего без кэша, false если маршрута нет; буферы rout_stat
+        // и ребер пути переиспользуются, так что повторные запросы не выделяют память
+        bool BuildRouteStat(size_t id_stop_from, size_t id_stop_to, RoutStat &rout_stat) const;
+
+        // имя остановки или автобуса элемента маршрута
+        std::string_view GetItemName(const RoutStat::Item &item) const;
 
-        // создает и возвращает маршрутизатор если его еще нет
-        const std::unique_ptr<graph::Router<double>> &GetRouter() const;
+        // маршруты из одной остановки в каждую из остановок ids_stop_to, в том же порядке;
+        // маршруты, которых нет в кэше, строятся одним пакетным запросом к маршрутизатору
+        std::vector<RoutStatPtr> GetRouteStats(size_t id_stop_from, const std::vector<size_t> &ids_stop_to) const;
+
+        // маршрут по расписанию автобусов с самым ранним прибытием при отправлении не раньше departure_time;
+        // ожидание - до ближайшего рейса, а не bus_wait_time; nullptr если маршрута нет
+        RoutStatPtr GetTimetableRouteStat(size_t id_stop_from, size_t id_stop_to, double departure_time) const;
+
+        // до count различных маршрутов по возрастанию времени (алгоритм Йена), первый - кратчайший
+        std::vector<RoutStatPtr> GetAlternativeRouteStats(size_t id_stop_from, size_t id_stop_to, size_t count) const;
+
+        // матрица времени в пути: строка на каждую остановку ids_stop_from, столбец на каждую ids_stop_to;
+        // на строку - один пакетный запрос к маршрутизатору, строки считаются параллельно
+        TimeMatrix GetTimeMatrix(const std::vector<size_t> &ids_stop_from, const std::vector<size_t> &ids_stop_to) const;
+
+        // остановки, до которых можно доехать не дольше max_time минут, по возрастанию времени;
+        // поиск по графу прекращается, как только время превышает max_time
+        std::vector<ReachableStop> GetReachableStops(const Stop *stop_from, double max_time) const;
+
+        // счетчики попаданий и промахов кэша маршрутов
+        size_t GetRouteCacheHits() const;
+
+        size_t GetRouteCacheMisses() const;
+
+        // создает и возвращает маршрутизатор если его еще нет, тип маршрутизатора задается в routing_settings
+        const std::unique_ptr<graph::RouterBase<RouteWeight>> &GetRouter() const;
 
         // Граф не создан
         bool GetGraphIsNoInit() const;
@@ -41,32 +116,184 @@ namespace TransportRouter {
 
         const std::vector<std::string> &GetIdStopes() const;
 
-        const graph::DirectedWeightedGraph<double> &GetGraph() const;
+        // вершина графа каждой остановки справочника, NO_VERTEX у остановок, через которые не ходят автобусы
+        const std::vector<graph::VertexId> &GetStopVertices() const;
+
+        const graph::DirectedWeightedGraph<RouteWeight> &GetGraph() const;
 
         void SetEdgesBuses(std::vector<EdgeAditionInfo> &&edges_buses);
 
         void SetIdStopes(std::vector<std::string> &&id_stopes);
 
-        void SetGraph(graph::DirectedWeightedGraph<double> &&graph);
+        void SetStopVertices(std::vector<graph::VertexId> &&stop_vertices);
+
+        void SetGraph(graph::DirectedWeightedGraph<RouteWeight> &&graph);
+
+        // строит маршрутизатор по расписанию из автобусов справочника, у которых задано расписание
+        void CreateTimetable(const TransportCatalogue::TransportCatalogue &db);
+
+        // Обновления без полного перестроения графа и таблицы маршрутов; справочник db уже содержит изменение.
+        // Таблица маршрутизатора всех пар чинится по строкам, остальные маршрутизаторы строятся заново.
+
+        // изменилось расстояние между остановками: меняются веса ребер автобусов, проходящих между ними
+        void UpdateDistance(const TransportCatalogue::TransportCatalogue &db, const Stop *stop_from,
+                            const Stop *stop_to);
+
+        // в справочник добавлен автобус bus; в модели Linear граф строится заново
+        void AddBus(const TransportCatalogue::TransportCatalogue &db, const Bus &bus);
+
+        // из справочника удален автобус bus_name; в модели Linear граф строится заново
+        void RemoveBus(const TransportCatalogue::TransportCatalogue &db, std::string_view bus_name);
+
+        // связывает вершины графа с остановками справочника (нужно для оценки A*) и номера автобусов с именами,
+        // граф должен быть уже задан
+        void BindStops(const TransportCatalogue::TransportCatalogue &db);
+
+        // маршрутизатор всех пар с таблицей последних ребер, если выбран этот тип маршрутизатора и таблицы, иначе nullptr
+        const AllPairsRouter *GetAllPairsRouter() const;
+
+        // маршрутизатор всех пар с таблицей первых шагов, если выбран этот тип таблицы, иначе nullptr
+        const graph::NextHopRouter<RouteWeight> *GetNextHopRouter() const;
+
+        // создает маршрутизатор всех пар по сохраненной таблице первых шагов, граф должен быть уже задан
+        void SetNextHopTable(graph::NextHopTable &&table);
+
+        // создает маршрутизатор всех пар по сохраненной таблице, граф должен быть уже задан
+        void SetAllPairsTable(std::vector<AllPairsRouter::TableWeightType> &&weights,
+                              std::vector<AllPairsRouter::TableEdgeIdType> &&prev_edges);
+
+        // то же по таблице во внешней памяти, которой владеет table_holder
+        void SetAllPairsTable(const AllPairsRouter::TableWeightType *weights,
+                              const AllPairsRouter::TableEdgeIdType *prev_edges,
+                              std::shared_ptr<const void> table_holder);
+
+        // иерархия сжатия графа, строится при первом обращении
+        const graph::ContractionHierarchy<RouteWeight> &GetContractionHierarchy() const;
+
+        void SetContractionHierarchy(graph::ContractionHierarchy<RouteWeight> &&hierarchy);
+
+        // метки компонент связности графа, считаются при построении графа и хранятся в базе
+        const graph::ComponentLabels &GetComponentLabels() const;
+
+        void SetComponentLabels(graph::ComponentLabels &&labels);
 
         const RoutingSettings &GetRoutingSettings() const;
 
         void SetRoutingSettings(RoutingSettings &&routing_settings);
 
     private:
+        // меньше автобусов граф строится в одном потоке: запуск потоков дороже самой работы
+        static constexpr size_t MIN_PARALLEL_BUSES = 64;
+
+        // хэш пары номеров остановок для кэша маршрутов
+        struct StopPairHasher {
+            size_t operator()(const std::pair<size_t, size_t> &stops) const {
+                return stops.first * 37'000'003 + stops.second;
+            }
+        };
+
+        using RouteCache = cache::LruCache<std::pair<size_t, size_t>, RoutStatPtr, StopPairHasher>;
+
+        // собирает статистику по построенному маршруту
+        RoutStatPtr MakeRouteStat(const OptRouteInfo &opt_route_info) const;
+
+        // заполняет rout_stat по весу и ребрам маршрута
+        void FillRouteStat(RouteWeight weight, const std::vector<graph::EdgeId> &edges, RoutStat &rout_stat) const;
+
+        // сбрасывает кэш маршрутов после изменения графа
+        void ClearRouteCache();
+
+        // уже созданный маршрутизатор всех пар с таблицей последних ребер, которую можно чинить при изменениях,
+        // иначе nullptr
+        AllPairsRouter *GetUpdatableAllPairsRouter();
+
+        // тип таблицы маршрутизатора всех пар, если выбран маршрутизатор всех пар
+        bool HasAllPairsTable(AllPairsTable table) const;
+
+        // маршрут между остановками может существовать: остановки не разделены компонентами графа
+        bool MayReach(size_t id_stop_from, size_t id_stop_to) const;
+
+        // нумерует вершины остановок: вершины получают только остановки автобусов, подряд с нуля
+        // в порядке routing_settings_.stop_order
+        void NumberStopVertices(const TransportCatalogue::TransportCatalogue &db);
+
+        // упорядочивает остановки по кривой Гильберта в прямоугольнике их координат
+        static void OrderStopsByHilbertCurve(std::vector<const Stop *> &stops);
+
+        // обслуживаемые остановки в порядке обхода в ширину по соседним остановкам маршрутов автобусов
+        static std::vector<const Stop *> OrderStopsByBuses(const TransportCatalogue::TransportCatalogue &db,
+                                                           const std::vector<char> &is_served);
+
+        // модель Complete: ребро от каждой остановки автобуса до каждой следующей
+        void CreateGraphComplete(const TransportCatalogue::TransportCatalogue &db);
+
+        // модель Linear: вершины остановок [0, кол-во остановок автобусов) и по вершине на каждую позицию
+        // в маршруте каждого автобуса; ребра посадки, пролетов и высадки
+        void CreateGraphLinear(const TransportCatalogue::TransportCatalogue &db);
+
+        // добавляет ребра всех автобусов справочника по модели графа; автобусы обрабатываются параллельно частями,
+        // части склеиваются в порядке автобусов, поэтому номера ребер не зависят от числа потоков
+        void BuildBusesEdges(const TransportCatalogue::TransportCatalogue &db,
+                             std::vector<graph::Edge<RouteWeight>> &edges,
+                             std::vector<EdgeAditionInfo> &edges_info) const;
+
+        // добавляет ребра автобуса модели Complete и сведения о них, bus_id - номер автобуса в справочнике
+        void AddBusEdgesComplete(const TransportCatalogue::TransportCatalogue &db, const Bus &bus, size_t bus_id,
+                                 std::vector<graph::Edge<RouteWeight>> &edges,
+                                 std::vector<EdgeAditionInfo> &edges_info) const;
+
+        // добавляет ребра автобуса модели Linear, first_ride_vertex - вершина его первой позиции
+        void AddBusEdgesLinear(const TransportCatalogue::TransportCatalogue &db, const Bus &bus, size_t bus_id,
+                               graph::VertexId first_ride_vertex, std::vector<graph::Edge<RouteWeight>> &edges,
+                               std::vector<EdgeAditionInfo> &edges_info) const;
+
+        // строит граф заново по справочнику, маршрутизаторы сбрасываются
+        void RebuildGraph(const TransportCatalogue::TransportCatalogue &db);
+
+        // полуинтервал номеров ребер автобуса
+        std::pair<graph::EdgeId, graph::EdgeId> FindBusEdges(size_t bus_id) const;
+
+        // меняет веса ребер графа и чинит маршрутизатор
+        void ApplyEdgeWeights(const std::vector<std::pair<graph::EdgeId, RouteWeight>> &changes);
+
+        // наибольшее отношение расстояния по прямой между концами ребра к весу ребра, м/мин;
+        // с такой скоростью оценка A* не превышает вес ни одного ребра и остается согласованной
+        double ComputeTopSpeed() const;
+
         // параметры маршрута скорость, ожидание
         RoutingSettings routing_settings_;
 
         // хранит дополнительная информация о ребре по индексу ребра
         std::vector<EdgeAditionInfo> edges_buses_;
 
-        // хранит имена остановок по индексу
+        // хранит имена остановок по номеру вершины
         std::vector<std::string> id_stopes_;
 
+        // номер вершины по номеру остановки в справочнике
+        std::vector<graph::VertexId> stop_vertices_;
+
+        // имена автобусов по номеру в справочнике, на них ссылаются элементы маршрутов
+        std::vector<std::string> bus_names_;
+
         // граф
-        std::optional<graph::DirectedWeightedGraph<double>> opt_graph_;
+        std::optional<graph::DirectedWeightedGraph<RouteWeight>> opt_graph_;
+
+        // остановка, в которой находится вершина графа
+        std::vector<const Stop *> vertex_stops_;
+
+        // компоненты связности графа, меняются вместе с набором его ребер
+        graph::ComponentLabels components_;
+
+        // иерархия сжатия для маршрутизатора ContractionHierarchy
+        mutable std::optional<graph::ContractionHierarchy<RouteWeight>> opt_hierarchy_;
+
+        // маршрутизатор по расписанию, если хотя бы у одного автобуса есть расписание
+        std::optional<raptor::Raptor> opt_timetable_;
 
         // маршрутизатор
-        mutable std::unique_ptr<graph::Router<double>> up_router_;
+        mutable std::unique_ptr<graph::RouterBase<RouteWeight>> up_router_;
+
+        // кэш готовых маршрутов по паре (откуда, куда), создается если задан route_cache_size
+        std::unique_ptr<RouteCache> route_cache_;
     };
 }
\ No newline at end of file